@@ -0,0 +1,65 @@
+//
+//  PGCommandLine.h
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#pragma mark - PGCommandLine
+
+/**
+ * Headless front end over the server controller, data store and search controller, so
+ * servers can be listed, checked, started and stopped from scripts without loading the
+ * preference pane.
+ *
+ * Commands:
+ *
+ *   list [name ...]                                  saved servers and their settings
+ *   status [name ...]                                saved servers with their current status
+ *   start (name ... | --all)                         start saved servers
+ *   stop [--shutdown smart|fast|immediate] (name ... | --all)
+ *                                                    stop saved servers
+ *   discover [--installed]                           servers started outside the data store,
+ *                                                    and optionally installed servers
+ *   bench [--servers count] [--names count] [--max-subprocesses n] [--max-syscalls n] [--max-seconds s]
+ *                                                    add, duplicate and rename servers in a
+ *                                                    scratch data store, then discover, check,
+ *                                                    stop and start servers in an in-memory
+ *                                                    launchd, reporting the time and operations
+ *                                                    of each phase, and failing if a server
+ *                                                    phase exceeds a per-server budget
+ *
+ * All output is JSON on stdout. Errors are written to stderr, and the exit status is
+ * non-zero if any server failed.
+ */
+@interface PGCommandLine : NSObject
+
+/**
+ * Runs the command, spinning the main run loop until it is finished.
+ *
+ * @return the process exit status
+ */
+- (int)runWithArguments:(NSArray<NSString *> *)arguments;
+
+@end
@@ -0,0 +1,573 @@
+//
+//  PGCommandLine.m
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "PGCommandLine.h"
+#import "PGServerController.h"
+#import "PGServerDataStore.h"
+#import "PGSearchController.h"
+#import "PGFakeSystem.h"
+
+#define PGCommandLineName @"pgprefs"
+#define PGCommandLineUsageStatus 64
+#define PGCommandLineStatusKey @"Status"
+#define PGCommandLinePidKey @"Pid"
+#define PGCommandLineErrorKey @"Error"
+#define PGCommandLineExternalKey @"External"
+#define PGCommandLineStartedKey @"Started"
+#define PGCommandLineInstalledKey @"Installed"
+#define PGCommandLineBenchServers 10
+#define PGCommandLineBenchBinDirectory @"/usr/local/pgsql/bin"
+#define PGCommandLineBenchDataDirectory @"/usr/local/pgsql/bench"
+#define PGCommandLineBenchFirstPort 15432
+#define PGCommandLineBenchNames 10000
+#define PGCommandLineBenchNamePrefix @"Bench"
+#define PGCommandLineBenchAppID [NSString stringWithFormat:@"%@.%@", PGPrefsAppID, @"bench"]
+
+#pragma mark - Interfaces
+
+@interface PGCommandLine() <PGAuthDelegate, PGSearchDelegate>
+
+@property (nonatomic, strong) PGServerController *serverController;
+@property (nonatomic, strong) PGServerDataStore *dataStore;
+@property (nonatomic, strong) PGSearchController *searchController;
+
+/// Option names mapped to values, or @YES for flags
+@property (nonatomic, strong) NSDictionary<NSString *, id> *options;
+/// Non-option arguments after the command
+@property (nonatomic, strong) NSArray<NSString *> *names;
+
+@property (nonatomic) BOOL finished;
+@property (nonatomic) int exitStatus;
+
+/**
+ * Parses the arguments and starts the command.
+ *
+ * @return NO if the command or its arguments are invalid
+ */
+- (BOOL)runCommand:(NSString *)command arguments:(NSArray<NSString *> *)arguments error:(NSString **)error;
+
+/**
+ * Splits arguments into options and names, checking options against those allowed.
+ *
+ * @return NO if an option is unknown or is missing its value
+ */
+- (BOOL)parseArguments:(NSArray<NSString *> *)arguments allowedFlags:(NSArray<NSString *> *)flags values:(NSArray<NSString *> *)values error:(NSString **)error;
+
+/**
+ * Saved servers matching the names, or all saved servers if no names and all is YES.
+ *
+ * @return nil if a name is not found, or no names and all is NO
+ */
+- (NSArray<PGServer *> *)serversForNames:(NSArray<NSString *> *)names all:(BOOL)all error:(NSString **)error;
+
+/**
+ * Runs the action on the servers, then prints their status and finishes.
+ */
+- (void)runAction:(PGServerAction)action servers:(NSArray<PGServer *> *)servers;
+
+- (NSDictionary *)JSONFromServer:(PGServer *)server status:(BOOL)status;
+- (void)printJSON:(id)object;
+- (void)printError:(NSString *)error;
+- (void)printUsage;
+- (void)finishWithStatus:(int)status;
+
+@end
+
+
+
+#pragma mark - PGCommandLine
+
+@implementation PGCommandLine
+{
+    AuthorizationRef _authorization;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.serverController = [[PGServerController alloc] init];
+        self.dataStore = [[PGServerDataStore alloc] init];
+        self.searchController = [[PGSearchController alloc] init];
+        self.dataStore.serverController = self.serverController;
+        self.searchController.serverController = self.serverController;
+        self.searchController.delegate = self;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_authorization) AuthorizationFree(_authorization, kAuthorizationFlagDefaults);
+}
+
+
+
+#pragma mark Commands
+
+- (int)runWithArguments:(NSArray<NSString *> *)arguments
+{
+    NSString *command = arguments.firstObject;
+    arguments = arguments.count > 1 ? [arguments subarrayWithRange:NSMakeRange(1, arguments.count - 1)] : @[];
+    
+    // Invalid
+    NSString *error = nil;
+    if (![self runCommand:command arguments:arguments error:&error]) {
+        [self printError:error];
+        [self printUsage];
+        return PGCommandLineUsageStatus;
+    }
+    
+    // Wait for actions to finish, on main thread so that callbacks are delivered
+    while (!self.finished) {
+        @autoreleasepool {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+        }
+    }
+    [self.dataStore synchronize];
+    return self.exitStatus;
+}
+
+- (BOOL)runCommand:(NSString *)command arguments:(NSArray<NSString *> *)arguments error:(NSString **)error
+{
+    NSArray *servers = nil;
+    
+    // List
+    if ([command isEqualToString:@"list"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty"] values:@[] error:error]) return NO;
+        if (!(servers = [self serversForNames:self.names all:YES error:error])) return NO;
+        [self listServers:servers];
+        
+    // Status
+    } else if ([command isEqualToString:@"status"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty"] values:@[] error:error]) return NO;
+        if (!(servers = [self serversForNames:self.names all:YES error:error])) return NO;
+        [self runAction:PGServerCheckStatus servers:servers];
+        
+    // Start
+    } else if ([command isEqualToString:@"start"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty", @"all"] values:@[] error:error]) return NO;
+        if (!(servers = [self serversForNames:self.names all:ToBOOL(self.options[@"all"]) error:error])) return NO;
+        [self runAction:PGServerStart servers:servers];
+        
+    // Stop
+    } else if ([command isEqualToString:@"stop"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty", @"all"] values:@[@"shutdown"] error:error]) return NO;
+        if (!(servers = [self serversForNames:self.names all:ToBOOL(self.options[@"all"]) error:error])) return NO;
+        
+        // Shutdown mode overrides the servers' own, but is not saved
+        NSString *shutdownName = ToString(self.options[@"shutdown"]);
+        if (shutdownName) {
+            PGServerShutdown shutdown = ToServerShutdown(shutdownName);
+            if ([NSStringFromPGServerShutdown(shutdown) caseInsensitiveCompare:shutdownName] != NSOrderedSame) {
+                if (error) *error = [NSString stringWithFormat:@"Unknown shutdown mode: %@", shutdownName];
+                return NO;
+            }
+            for (PGServer *server in servers) server.shutdown = shutdown;
+        }
+        [self runAction:PGServerStop servers:servers];
+        
+    // Discover
+    } else if ([command isEqualToString:@"discover"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty", @"installed"] values:@[] error:error]) return NO;
+        [self discoverServers];
+        
+    // Benchmark
+    } else if ([command isEqualToString:@"bench"]) {
+        if (![self parseArguments:arguments allowedFlags:@[@"pretty"] values:@[@"servers", @"names", @"max-subprocesses", @"max-syscalls", @"max-seconds"] error:error]) return NO;
+        NSInteger count = self.options[@"servers"] ? ToString(self.options[@"servers"]).integerValue : PGCommandLineBenchServers;
+        if (count <= 0) {
+            if (error) *error = [NSString stringWithFormat:@"Invalid number of servers: %@", self.options[@"servers"]];
+            return NO;
+        }
+        NSInteger names = self.options[@"names"] ? ToString(self.options[@"names"]).integerValue : PGCommandLineBenchNames;
+        if (names <= 0) {
+            if (error) *error = [NSString stringWithFormat:@"Invalid number of names: %@", self.options[@"names"]];
+            return NO;
+        }
+        
+        // Budgets are per server, and apply to each phase
+        NSDictionary *budgetKeys = @{@"max-subprocesses":@"Subprocesses", @"max-syscalls":@"Syscalls", @"max-seconds":@"VirtualSeconds"};
+        NSMutableDictionary *budgets = [NSMutableDictionary dictionaryWithCapacity:budgetKeys.count];
+        for (NSString *option in budgetKeys) {
+            if (!self.options[option]) continue;
+            NSNumber *budget = ToNumber(self.options[option]);
+            if (!budget || budget.doubleValue < 0) {
+                if (error) *error = [NSString stringWithFormat:@"Invalid value for option --%@: %@", option, self.options[option]];
+                return NO;
+            }
+            budgets[budgetKeys[option]] = @(budget.doubleValue * count);
+        }
+        [self benchmarkWithServers:count names:names budgets:budgets];
+        
+    // Unknown
+    } else {
+        if (error) *error = command ? [NSString stringWithFormat:@"Unknown command: %@", command] : nil;
+        return NO;
+    }
+    return YES;
+}
+
+- (void)listServers:(NSArray<PGServer *> *)servers
+{
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:servers.count];
+    for (PGServer *server in servers) [result addObject:[self JSONFromServer:server status:NO]];
+    [self printJSON:result];
+    [self finishWithStatus:EXIT_SUCCESS];
+}
+
+- (void)discoverServers
+{
+    NSMutableArray *started = [NSMutableArray array];
+    for (PGServer *server in [self.searchController startedServers]) {
+        [started addObject:[self JSONFromServer:server status:YES]];
+    }
+    
+    // Started only
+    if (!ToBOOL(self.options[@"installed"])) {
+        [self printJSON:@{PGCommandLineStartedKey:started}];
+        [self finishWithStatus:EXIT_SUCCESS];
+        return;
+    }
+    
+    // Installed - spotlight results arrive on the run loop, so collect for a while
+    [self.searchController findInstalledServers];
+    MainThreadAfterDelay(PGCommandLineDiscoverTimeout, ^{
+        NSMutableArray *installed = [NSMutableArray array];
+        for (PGServer *server in self.searchController.servers) {
+            [installed addObject:[self JSONFromServer:server status:NO]];
+        }
+        [self printJSON:@{PGCommandLineStartedKey:started, PGCommandLineInstalledKey:installed}];
+        [self finishWithStatus:EXIT_SUCCESS];
+    });
+}
+
+/**
+ * Runs each phase against the fake system, and fails if a phase has failures or exceeds a budget.
+ *
+ * @param names number of servers to add, duplicate and rename in a scratch data store
+ * @param budgets maximum value of a server phase result, keyed by result key, e.g. Subprocesses
+ */
+- (void)benchmarkWithServers:(NSInteger)count names:(NSInteger)names budgets:(NSDictionary<NSString *, NSNumber *> *)budgets
+{
+    // Servers loaded in the fake launchd, as if started before the benchmark
+    PGFakeSystem *fake = [[PGFakeSystem alloc] init];
+    for (NSInteger i = 0; i < count; i++) {
+        [fake addDaemon:@{
+            @"Label": [NSString stringWithFormat:@"org.postgresql.bench-%@", @(i + 1)],
+            @"ProgramArguments": @[
+                    [PGCommandLineBenchBinDirectory stringByAppendingPathComponent:@"postgres"],
+                    @"-D", [PGCommandLineBenchDataDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"%@", @(i + 1)]],
+                    @"-p", [NSString stringWithFormat:@"%@", @(PGCommandLineBenchFirstPort + i)]
+            ]
+        } forRootUser:NO];
+    }
+    [fake install];
+    
+    // Name phases use the data store, which flushes on the main thread, so run them here
+    NSArray *nameResults = [self benchmarkNames:names fake:fake];
+    
+    // Phases run one at a time, and each action one server at a time, so virtual time is deterministic
+    BackgroundThread(^{
+        NSMutableArray *results = [NSMutableArray arrayWithArray:nameResults];
+        __block NSArray<PGServer *> *servers = nil;
+        __block NSUInteger failures = 0;
+        
+        [results addObject:[self benchmarkPhase:@"Discover" fake:fake budgets:budgets block:^NSUInteger{
+            servers = [self.searchController startedServers];
+            return servers.count == (NSUInteger)count ? 0 : 1;
+        }]];
+        
+        for (NSNumber *action in @[@(PGServerCheckStatus), @(PGServerStop), @(PGServerStart)]) {
+            [results addObject:[self benchmarkPhase:NSStringFromPGServerAction(action.integerValue) fake:fake budgets:budgets block:^NSUInteger{
+                __block NSUInteger errors = 0;
+                dispatch_semaphore_t done = dispatch_semaphore_create(0);
+                [self.serverController runAction:action.integerValue servers:servers auth:nil maxConcurrent:1 completed:^(NSDictionary<NSString *,NSString *> *actionErrors, NSTimeInterval duration) {
+                    errors = actionErrors.count;
+                    dispatch_semaphore_signal(done);
+                }];
+                dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+                return errors;
+            }]];
+        }
+        [fake uninstall];
+        
+        for (NSDictionary *result in results) {
+            failures += [result[@"Failures"] unsignedIntegerValue] + [result[@"OverBudget"] count];
+        }
+        MainThread(^{
+            [self printJSON:results];
+            [self finishWithStatus:failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE];
+        });
+    });
+}
+
+/**
+ * Adds, duplicates and renames servers in a scratch data store, to measure the cost of keeping
+ * the name index sorted and finding unused names. The store is emptied again afterwards.
+ *
+ * @return the phase results
+ */
+- (NSArray<NSDictionary *> *)benchmarkNames:(NSInteger)count fake:(PGFakeSystem *)fake
+{
+    PGServerDataStore *dataStore = [[PGServerDataStore alloc] initWithAppID:PGCommandLineBenchAppID];
+    dataStore.serverController = self.serverController;
+    [dataStore loadServers];
+    [dataStore removeAllServers];
+    
+    NSMutableArray<PGServer *> *servers = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:3];
+    
+    // Same prefix every time, so each name needs the next unused number
+    [results addObject:[self benchmarkPhase:@"Add" fake:fake budgets:nil block:^NSUInteger{
+        for (NSInteger i = 0; i < count; i++) {
+            PGServer *server = [dataStore addServerWithName:PGCommandLineBenchNamePrefix];
+            if (server) [servers addObject:server];
+        }
+        return dataStore.servers.count == (NSUInteger)count ? 0 : 1;
+    }]];
+    
+    // As for the Duplicate button
+    [results addObject:[self benchmarkPhase:@"Duplicate" fake:fake budgets:nil block:^NSUInteger{
+        NSUInteger failures = 0;
+        for (NSInteger i = 0; i < count; i++) {
+            PGServer *server = [dataStore addServerWithName:servers[i].shortName settings:servers[i].settings];
+            if (!server) failures++;
+        }
+        return failures + (dataStore.servers.count == (NSUInteger)(2 * count) ? 0 : 1);
+    }]];
+    
+    // As for the rename sheet
+    [results addObject:[self benchmarkPhase:@"Rename" fake:fake budgets:nil block:^NSUInteger{
+        NSUInteger failures = 0;
+        for (NSInteger i = 0; i < count; i++) {
+            NSString *name = [NSString stringWithFormat:@"Renamed %@", @(i + 1)];
+            if (![self.serverController setName:name forServer:servers[i]] || ![dataStore saveServer:servers[i]]) failures++;
+        }
+        return failures + (dataStore.servers.count == (NSUInteger)(2 * count) ? 0 : 1);
+    }]];
+    
+    [dataStore removeAllServers];
+    [dataStore synchronize];
+    return results;
+}
+
+/**
+ * Runs the block, and measures the virtual time, wall time and operations it used.
+ * The block returns the number of failures. Results above their budget are listed as OverBudget.
+ */
+- (NSDictionary *)benchmarkPhase:(NSString *)name fake:(PGFakeSystem *)fake budgets:(NSDictionary<NSString *, NSNumber *> *)budgets block:(NSUInteger(^)(void))block
+{
+    [fake resetCounts];
+    NSTimeInterval virtualStart = fake.now;
+    NSTimeInterval wallStart = [NSProcessInfo processInfo].systemUptime;
+    
+    NSUInteger failures = block();
+    
+    NSMutableDictionary *result = [@{
+        @"Phase": name,
+        @"VirtualSeconds": @(fake.now - virtualStart),
+        @"WallSeconds": @([NSProcessInfo processInfo].systemUptime - wallStart),
+        @"Subprocesses": @(fake.subprocesses),
+        @"Syscalls": @(fake.syscalls),
+        @"Operations": fake.counts,
+        @"Failures": @(failures)
+    } mutableCopy];
+    
+    NSMutableArray *overBudget = [NSMutableArray array];
+    for (NSString *key in [budgets.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        if ([result[key] doubleValue] > budgets[key].doubleValue) [overBudget addObject:key];
+    }
+    if (overBudget.count > 0) result[@"OverBudget"] = overBudget;
+    return result;
+}
+
+
+
+#pragma mark PGAuthDelegate
+
+- (AuthorizationRef)authorize:(PGAuth *)auth
+{
+    // Called at most once per action, possibly on a background thread
+    @synchronized(self) {
+        if (_authorization) return _authorization;
+        
+        AuthorizationFlags flags = kAuthorizationFlagDefaults | kAuthorizationFlagInteractionAllowed | kAuthorizationFlagExtendRights | kAuthorizationFlagPreAuthorize;
+        AuthorizationRef authorization = NULL;
+        OSStatus status = AuthorizationCreate(self.serverController.rights.authorizationRights, kAuthorizationEmptyEnvironment, flags, &authorization);
+        if (status != errAuthorizationSuccess) {
+            if (authorization) AuthorizationFree(authorization, kAuthorizationFlagDefaults);
+            return NULL;
+        }
+        _authorization = authorization;
+        return _authorization;
+    }
+}
+
+
+
+#pragma mark PGSearchDelegate
+
+- (void)didFindMoreServers:(PGSearchController *)search
+{
+    DLog(@"Found %@ installed servers", @(search.servers.count));
+}
+
+
+
+#pragma mark Private
+
+- (BOOL)parseArguments:(NSArray<NSString *> *)arguments allowedFlags:(NSArray<NSString *> *)flags values:(NSArray<NSString *> *)values error:(NSString **)error
+{
+    NSMutableDictionary *options = [NSMutableDictionary dictionary];
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity:arguments.count];
+    
+    for (NSUInteger i = 0; i < arguments.count; i++) {
+        NSString *argument = arguments[i];
+        if (![argument hasPrefix:@"--"]) {
+            [names addObject:argument];
+            continue;
+        }
+        
+        // Option, either --name value or --name=value
+        NSString *option = [argument substringFromIndex:2];
+        NSString *value = nil;
+        NSRange equals = [option rangeOfString:@"="];
+        if (equals.location != NSNotFound) {
+            value = [option substringFromIndex:NSMaxRange(equals)];
+            option = [option substringToIndex:equals.location];
+        }
+        
+        if ([flags containsObject:option] && !value) {
+            options[option] = @YES;
+        } else if ([values containsObject:option]) {
+            if (!value && i + 1 < arguments.count) value = arguments[++i];
+            if (!NonBlank(value)) {
+                if (error) *error = [NSString stringWithFormat:@"Missing value for option: --%@", option];
+                return NO;
+            }
+            options[option] = value;
+        } else {
+            if (error) *error = [NSString stringWithFormat:@"Unknown option: %@", argument];
+            return NO;
+        }
+    }
+    
+    self.options = options;
+    self.names = names;
+    return YES;
+}
+
+- (NSArray<PGServer *> *)serversForNames:(NSArray<NSString *> *)names all:(BOOL)all error:(NSString **)error
+{
+    [self.dataStore loadServers];
+    
+    // All
+    if (names.count == 0) {
+        if (!all && error) *error = @"Specify server names or --all";
+        return all ? self.dataStore.servers : nil;
+    }
+    
+    // Named
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:names.count];
+    for (NSString *name in names) {
+        PGServer *server = [self.dataStore serverWithName:name];
+        if (!server) {
+            if (error) *error = [NSString stringWithFormat:@"No server named: %@", name];
+            return nil;
+        }
+        if (![result containsObject:server]) [result addObject:server];
+    }
+    return result;
+}
+
+- (void)runAction:(PGServerAction)action servers:(NSArray<PGServer *> *)servers
+{
+    // Single auth for all servers, so user only asked for password once
+    PGAuth *auth = [[PGAuth alloc] initWithDelegate:self];
+    
+    [self.serverController runAction:action servers:servers auth:auth maxConcurrent:PGServersBulkActionMaxConcurrent completed:^(NSDictionary<NSString *,NSString *> *errors, NSTimeInterval duration) {
+        NSMutableArray *result = [NSMutableArray arrayWithCapacity:servers.count];
+        for (PGServer *server in servers) {
+            NSMutableDictionary *json = [[self JSONFromServer:server status:YES] mutableCopy];
+            if (errors[server.uid]) json[PGCommandLineErrorKey] = errors[server.uid];
+            [result addObject:json];
+        }
+        [self printJSON:result];
+        [self finishWithStatus:errors.count == 0 ? EXIT_SUCCESS : EXIT_FAILURE];
+    }];
+}
+
+- (NSDictionary *)JSONFromServer:(PGServer *)server status:(BOOL)status
+{
+    NSMutableDictionary *result = [server.properties mutableCopy];
+    result[PGServerNameKey] = server.name ?: @"";
+    result[PGServerDomainKey] = server.domain ?: @"";
+    result[PGCommandLineExternalKey] = @(server.external);
+    if (status) {
+        result[PGCommandLineStatusKey] = NSStringFromPGServerStatus(server.status);
+        if (server.pid > 0) result[PGCommandLinePidKey] = @(server.pid);
+        if (NonBlank(server.error)) result[PGCommandLineErrorKey] = server.error;
+    }
+    return result;
+}
+
+- (void)printJSON:(id)object
+{
+    NSJSONWritingOptions options = NSJSONWritingSortedKeys | (ToBOOL(self.options[@"pretty"]) ? NSJSONWritingPrettyPrinted : 0);
+    NSData *data = [NSJSONSerialization dataWithJSONObject:object options:options error:nil];
+    fwrite(data.bytes, 1, data.length, stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+- (void)printError:(NSString *)error
+{
+    if (!error) return;
+    fprintf(stderr, "%s: %s\n", PGCommandLineName.UTF8String, error.UTF8String);
+}
+
+- (void)printUsage
+{
+    fprintf(stderr,
+            "usage: %1$s list [--pretty] [name ...]\n"
+            "       %1$s status [--pretty] [name ...]\n"
+            "       %1$s start [--pretty] (name ... | --all)\n"
+            "       %1$s stop [--pretty] [--shutdown smart|fast|immediate] (name ... | --all)\n"
+            "       %1$s discover [--pretty] [--installed]\n"
+            "       %1$s bench [--pretty] [--servers count] [--names count] [--max-subprocesses n] [--max-syscalls n] [--max-seconds s]\n",
+            PGCommandLineName.UTF8String);
+}
+
+- (void)finishWithStatus:(int)status
+{
+    MainThread(^{
+        self.exitStatus = status;
+        self.finished = YES;
+    });
+}
+
+@end
@@ -46,9 +46,11 @@
 - (void)deauthorize;
 
 - (void)prefsController:(PGPrefsController *)controller willEditServerSettings:(PGServer *)server;
+- (void)prefsController:(PGPrefsController *)controller willViewLog:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServers:(NSArray *)servers;
 - (void)prefsController:(PGPrefsController *)controller didChangeSelectedServer:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerStatus:(PGServer *)server;
+- (void)prefsController:(PGPrefsController *)controller didChangeServerUsage:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerSetting:(NSString *)setting server:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerSettings:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didApplyServerSettings:(PGServer *)server;
@@ -117,6 +119,15 @@
 
 // Start/Stop
 - (void)userDidStartStopServer;
+- (void)userDidStopServerWithShutdown:(PGServerShutdown)shutdown;
+- (void)userDidStartAllServers;
+- (void)userDidStopAllServers;
+- (void)userDidRestartAllServers;
+
+// Import/Export
+/// Completion is called on main thread. Imported is NO if no servers were added.
+- (void)userDidImportServersFromFile:(NSString *)path completion:(void(^)(BOOL imported, NSString *error))completion;
+- (BOOL)userDidExportServersToFile:(NSString *)path error:(NSString **)error;
 
 // Settings
 - (void)userDidSelectSearchServer:(PGServer *)server;
@@ -129,6 +140,7 @@
 
 // Log
 - (void)userDidViewLog;
+- (void)userDidViewLogInConsole;
 
 // PGServerDelegate
 - (void)server:(PGServer *)server willRunAction:(PGServerAction)action;
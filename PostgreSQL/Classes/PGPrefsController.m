@@ -106,6 +106,42 @@
 
 
 
+#pragma mark - PGServersSnapshot
+
+/**
+ * Immutable copy of the servers list, for use by background threads.
+ *
+ * A new snapshot is published whenever the servers list changes, so background threads
+ * can check membership without waiting on the main thread.
+ */
+@interface PGServersSnapshot : NSObject
+@property (nonatomic, strong, readonly) NSArray<PGServer *> *servers;
+- (instancetype)initWithServers:(NSArray<PGServer *> *)servers;
+- (BOOL)containsServer:(PGServer *)server;
+@end
+
+@interface PGServersSnapshot()
+@property (nonatomic, strong) NSSet<PGServer *> *membership;
+@end
+
+@implementation PGServersSnapshot
+- (instancetype)initWithServers:(NSArray<PGServer *> *)servers
+{
+    self = [super init];
+    if (self) {
+        _servers = servers ? [servers copy] : @[];
+        _membership = [NSSet setWithArray:_servers];
+    }
+    return self;
+}
+- (BOOL)containsServer:(PGServer *)server
+{
+    return server && [_membership containsObject:server];
+}
+@end
+
+
+
 #pragma mark - Interfaces
 
 @interface PGPrefsController () <PGAuthDelegate>
@@ -115,7 +151,13 @@
 @property (nonatomic, strong, readwrite) PGServerDataStore *dataStore;
 @property (nonatomic, strong, readwrite) PGServer *server;
 @property (nonatomic, strong, readwrite) NSArray *servers;
-@property (nonatomic, readwrite) AuthorizationRef authorization;
+/// Published copy of servers - safe to read from any thread
+@property (atomic, strong) PGServersSnapshot *serversSnapshot;
+/// Authorization kept between actions, while its rights are still valid
+@property (nonatomic, strong) PGAuthSession *authSession;
+/// Servers not yet checked since the view loaded, by uid, and when loading started - for timing
+@property (nonatomic, strong) NSMutableSet<NSString *> *unreconciledServers;
+@property (nonatomic) NSTimeInterval loadTime;
 /// Used to start/stop all monitor threads. The monitor threads take a reference to this manager
 /// when they start running, and periodically check if it is still enabled. If not, they exit.
 @property (nonatomic, strong) PGThreadManager *serversMonitorManager;
@@ -146,7 +188,7 @@
         self.searchController.delegate = self;
         self.searchController.serverController = self.serverController;
         self.dataStore.serverController = self.serverController;
-        self.authorization = nil;
+        self.authSession = [[PGAuthSession alloc] initWithRights:self.serverController.rights];
     }
     return self;
 }
@@ -158,12 +200,21 @@
     [self.viewController prefsController:self didChangeSelectedServer:nil];
     
     // Load servers from plist
+    self.loadTime = [NSProcessInfo processInfo].systemUptime;
     [self.dataStore loadServers];
+    
+    // Show last-known status straight away - checked when monitoring starts
+    NSUInteger restored = [self.dataStore restoreStatusSnapshot];
+    
+    // The list shows and monitors every server, so all are created here
     self.servers = self.dataStore.servers;
     self.server = self.servers.firstObject;
+    self.unreconciledServers = [NSMutableSet setWithArray:[self.servers valueForKey:@"uid"] ?: @[]];
     
     [self.viewController prefsController:self didChangeServers:self.servers];
     [self.viewController prefsController:self didChangeSelectedServer:self.server];
+    
+    DLog(@"First paint: %@ servers, %@ from snapshot, %.3fs", @(self.servers.count), @(restored), [NSProcessInfo processInfo].systemUptime - self.loadTime);
 }
 - (void)viewWillAppear
 {
@@ -178,6 +229,8 @@
 {
     // Ensure saved preferences are written to disk
     [[NSUserDefaults standardUserDefaults] synchronize];
+    [self.dataStore synchronize];
+    [self.dataStore saveStatusSnapshot];
     
     [self.viewController deauthorize];
     
@@ -190,7 +243,7 @@
 }
 - (void)viewDidAuthorize:(AuthorizationRef)authorization
 {
-    self.authorization = authorization;
+    [self.authSession setAuthorization:authorization];
 }
 //
 // DidDauthorize method will be called in any of following situations:
@@ -202,12 +255,23 @@
 {
     DLog(@"Deauthorized");
     
-    self.authorization = nil;
+    [self.authSession invalidate];
+}
+- (AuthorizationRef)authorization
+{
+    return self.authSession.authorization;
 }
 - (PGRights *)rights
 {
     return self.serverController.rights;
 }
+- (void)setServers:(NSArray *)servers
+{
+    mustBeMainThread();
+    
+    _servers = servers;
+    self.serversSnapshot = [[PGServersSnapshot alloc] initWithServers:servers];
+}
 
 
 
@@ -396,6 +460,69 @@
         [self checkStatus:self.server];
     }
 }
+- (void)userDidStopServerWithShutdown:(PGServerShutdown)shutdown
+{
+    if (!self.server.started) return;
+    
+    PGAuth *auth = [[PGAuth alloc] initWithDelegate:self];
+    PGServer *server = self.server;
+    [self.serverController runAction:PGServerStop server:server shutdown:shutdown auth:auth succeeded:^{
+        MainThreadAfterDelay(0.2, ^{
+            [self checkStatus:server];
+        });
+    } failed:nil];
+}
+- (void)userDidStartAllServers
+{
+    [self runAction:PGServerStart onServersPassingTest:^BOOL(PGServer *server) {
+        return server.status == PGServerStopped;
+    }];
+}
+- (void)userDidStopAllServers
+{
+    [self runAction:PGServerStop onServersPassingTest:^BOOL(PGServer *server) {
+        return server.started;
+    }];
+}
+- (void)userDidRestartAllServers
+{
+    // Note: start action always restarts
+    [self runAction:PGServerStart onServersPassingTest:^BOOL(PGServer *server) {
+        return server.started;
+    }];
+}
+
+
+
+#pragma mark Import/Export
+
+- (void)userDidImportServersFromFile:(NSString *)path completion:(void (^)(BOOL, NSString *))completion
+{
+    [self.dataStore importServersFromFile:path completion:^(NSArray<PGServer *> *imported, NSString *error) {
+        if (imported.count == 0) {
+            if (completion) completion(NO, error ?: (imported ? @"No valid servers found in file" : nil));
+            return;
+        }
+        
+        // Get the new servers list after import
+        self.servers = self.dataStore.servers;
+        
+        // Select the first imported server
+        self.server = imported.firstObject;
+        
+        // Start monitoring
+        for (PGServer *server in imported) [self startMonitoringServer:server];
+        
+        [self.viewController prefsController:self didChangeServers:self.servers];
+        [self.viewController prefsController:self didChangeSelectedServer:self.server];
+        
+        if (completion) completion(YES, error);
+    }];
+}
+- (BOOL)userDidExportServersToFile:(NSString *)path error:(NSString *__autoreleasing *)error
+{
+    return [self.dataStore exportServers:self.servers toFile:path error:error];
+}
 
 
 
@@ -405,6 +532,9 @@
 {
     [self.searchController findInstalledServers];
     
+    // Get rights ready for applying settings, if possible without a password
+    [self.authSession preauthorizeWithCompletion:nil];
+    
     [self.serverController clean:self.server];
     
     [self.viewController prefsController:self willEditServerSettings:self.server];
@@ -523,6 +653,12 @@
 #pragma mark Log
 
 - (void)userDidViewLog
+{
+    if (!self.server.daemonLogExists) return;
+    
+    [self.viewController prefsController:self willViewLog:self.server];
+}
+- (void)userDidViewLogInConsole
 {
     if (!self.server.daemonLogExists) return;
 
@@ -552,7 +688,12 @@
 }
 - (void)server:(PGServer *)server didRunAction:(PGServerAction)action
 {
-    // Do nothing
+    // Time until every server shown has been checked since loading
+    if (self.unreconciledServers.count == 0) return;
+    [self.unreconciledServers removeObject:server.uid];
+    if (self.unreconciledServers.count == 0) {
+        DLog(@"Reconciled: %@ servers, %.3fs", @(self.servers.count), [NSProcessInfo processInfo].systemUptime - self.loadTime);
+    }
 }
 
 
@@ -570,11 +711,13 @@
 
 - (AuthorizationRef)authorize:(PGAuth *)auth
 {
-    if (self.authorization) {
-        return self.authorization;
-    } else {
-        return self.authorization = [self.viewController authorizeAndWait:auth];
-    }
+    // Still valid - no need to involve the view
+    AuthorizationRef authorization = [self.authSession validAuthorization];
+    if (authorization) return authorization;
+    
+    authorization = [self.viewController authorizeAndWait:auth];
+    [self.authSession setAuthorization:authorization];
+    return authorization;
 }
 
 - (void)checkStatus:(PGServer *)server
@@ -582,6 +725,26 @@
     [self.serverController runAction:PGServerCheckStatus server:server auth:nil];
 }
 
+- (void)runAction:(PGServerAction)action onServersPassingTest:(BOOL(^)(PGServer *server))test
+{
+    NSMutableArray *servers = [NSMutableArray arrayWithCapacity:self.servers.count];
+    for (PGServer *server in self.servers) {
+        if (!server.actionable || server.processing) continue;
+        if (test(server)) [servers addObject:server];
+    }
+    if (servers.count == 0) return;
+    
+    // Single auth for all servers, so user only asked for password once
+    PGAuth *auth = [[PGAuth alloc] initWithDelegate:self];
+    [self.serverController runAction:action servers:servers auth:auth maxConcurrent:PGServersBulkActionMaxConcurrent completed:^(NSDictionary<NSString *,NSString *> *errors, NSTimeInterval duration) {
+        MainThreadAfterDelay(0.2, ^{
+            for (PGServer *server in servers) {
+                if (!errors[server.uid]) [self checkStatus:server];
+            }
+        });
+    }];
+}
+
 - (void)deleteServerAndDeleteFile:(BOOL)delete
 {
     PGAuth *auth = [[PGAuth alloc] initWithDelegate:self];
@@ -651,26 +814,55 @@
     if (!controller.manager.enabled) { return; }
     
     // Ensure server not deleted
-    __block BOOL serverExists = YES;
-    MainThread(^{ serverExists = [self.servers containsObject:server]; });
-    if (!serverExists) return;
-    
-    // Run check status
-    [self checkStatus:server];
-    
-    // If stopped external server with no daemon file, delete it
-    if (server.external && server.status == PGServerStopped && !server.daemonFileExists) {
-        MainThread(^{ [self removeServer:server]; });
-    }
-    
+    if (![self.serversSnapshot containsServer:server]) return;
+    
+    // Run check status, then re-run once finished.
+    // Note: check status is queued per server, and merged with any check status
+    // already pending, so a slow check never piles up further checks behind it.
+    [self.serverController runAction:PGServerCheckStatus server:server auth:nil succeeded:^{
+        [self server:server didSucceedAction:PGServerCheckStatus];
+        [self didPollServer:server controller:controller];
+    } failed:^(NSString *error) {
+        [self server:server didFailAction:PGServerCheckStatus error:error];
+        [self didPollServer:server controller:controller];
+    }];
+}
+- (void)didPollServer:(PGServer *)server controller:(PGThreadController *)controller
+{
     // Ensure not stopped
     if (!controller.manager.enabled) { return; }
-
-    // Global disable auto-monitoring
-    if (!PGPrefsMonitorServersEnabled) { return; }
     
-    // Schedule re-run
-    BackgroundThreadAfterDelay(PGServersPollTime, ^{ [self pollServer:server controller:controller]; });
+    BackgroundThread(^{
+        // If stopped external server with no daemon file, delete it
+        if (server.external && server.status == PGServerStopped && !server.daemonFileExists) {
+            MainThread(^{ [self removeServer:server]; });
+            return;
+        }
+        
+        // Resource usage
+        NSUInteger samples = server.usageHistory.count;
+        if ([self.serverController sampleUsageForServer:server] || samples > 0) {
+            MainThreadAfterDelay(0, ^{
+                [self.viewController prefsController:self didChangeServerUsage:server];
+            });
+        }
+        
+        // Log rotation
+        BOOL unmanaged = server.daemonLogUnmanaged;
+        [self.serverController rotateLogForServer:server];
+        if (server.daemonLogUnmanaged != unmanaged) {
+            MainThread(^{ [self.viewController prefsController:self didChangeServerStatus:server]; });
+        }
+        
+        // Ensure not stopped
+        if (!controller.manager.enabled) { return; }
+        
+        // Global disable auto-monitoring
+        if (!PGPrefsMonitorServersEnabled) { return; }
+        
+        // Schedule re-run
+        BackgroundThreadAfterDelay(PGServersPollTime, ^{ [self pollServer:server controller:controller]; });
+    });
 }
 - (void)startMonitoringLaunchd
 {
@@ -689,7 +881,7 @@
     if (loadedServers.count > 0) {
         
         // Get existing servers by name
-        NSArray *existingServers = self.dataStore.servers;
+        NSArray *existingServers = self.serversSnapshot.servers;
         NSMutableDictionary *existingLookup = existingServers.count == 0 ? nil : [NSMutableDictionary dictionaryWithCapacity:existingServers.count];
         for (PGServer *server in existingServers) {
             if (!NonBlank(server.name) || !server.external) continue;
@@ -28,6 +28,7 @@
 #import <SecurityInterface/SFAuthorizationView.h>
 #import "PGPrefsController.h"
 #import "PGServer.h"
+#import "PGLogFile.h"
 
 #pragma mark - PGPrefsCenteredTextFieldCell
 
@@ -205,6 +206,45 @@
 
 
 
+#pragma mark - PGPrefsLogWindow
+
+/**
+ * Window that shows a server's log file. Created in code rather than in the nib.
+ *
+ * Lines are only read from the file as they scroll into view, so even a multi-GB log
+ * opens instantly. Appended lines are shown as they are written, and if scrolled to
+ * the bottom the window keeps following the end of the log.
+ *
+ * Lines can be filtered by severity and time, using the log file's index.
+ */
+@interface PGPrefsLogWindow : NSWindow <NSTableViewDataSource, NSTableViewDelegate, PGLogFileDelegate>
+@property (nonatomic, strong, readonly) PGLogFile *logFile;
+@property (nonatomic, strong, readonly) NSTableView *tableView;
+@property (nonatomic, strong, readonly) NSTextField *statusField;
+@property (nonatomic, strong, readonly) NSPopUpButton *severityPopUp;
+@property (nonatomic, strong, readonly) NSPopUpButton *timePopUp;
+@property (nonatomic, strong, readonly) NSButton *consoleButton;
+@property (nonatomic, strong, readonly) NSButton *closeButton;
+- (instancetype)initWithLogFile:(PGLogFile *)logFile;
+@end
+
+
+
+#pragma mark - PGPrefsSparklineView
+
+/**
+ * A small line graph of recent values, with a short label showing the latest value.
+ */
+@interface PGPrefsSparklineView : NSView
+@property (nonatomic, strong) NSArray<NSNumber *> *values;
+/// The graph is scaled to the larger of this and the maximum value
+@property (nonatomic) double minimumScale;
+@property (nonatomic, strong) NSString *label;
+@property (nonatomic, strong) NSColor *lineColor;
+@end
+
+
+
 #pragma mark - PGPrefsPane
 
 /**
@@ -247,7 +287,16 @@
 
 // Log
 @property (weak) IBOutlet NSButton *viewLogButton;
+@property (nonatomic, strong) PGPrefsLogWindow *logWindow;
 - (IBAction)viewLogClicked:(id)sender;
+- (IBAction)viewLogInConsoleClicked:(id)sender;
+- (IBAction)closeLogWindowClicked:(id)sender;
+
+// Usage
+@property (nonatomic, strong) PGPrefsSparklineView *cpuSparkline;
+@property (nonatomic, strong) PGPrefsSparklineView *memorySparkline;
+@property (nonatomic, strong) PGPrefsSparklineView *filesSparkline;
+@property (nonatomic, strong) PGPrefsSparklineView *backendsSparkline;
 
 // Status
 @property (weak) IBOutlet NSImageView *statusImage;
@@ -279,12 +328,14 @@
 @property (weak) IBOutlet NSMenuItem *renameServerButton;
 @property (weak) IBOutlet NSSegmentedControl *serversButtons;
 @property (weak) IBOutlet NSSegmentedControl *noServersButtons;
+@property (nonatomic, strong) NSSearchField *serversFilterField;
 - (IBAction)serversButtonClicked:(id)sender;
 - (IBAction)renameServerClicked:(id)sender;
 - (IBAction)cancelRenameServerClicked:(id)sender;
 - (IBAction)okRenameServerClicked:(id)sender;
 - (IBAction)duplicateServerClicked:(id)sender;
 - (IBAction)refreshServersClicked:(id)sender;
+- (IBAction)serversFilterChanged:(id)sender;
 
 // Delete Confirmation
 @property (strong) IBOutlet PGPrefsDeleteWindow *deleteServerWindow;
@@ -296,6 +347,12 @@
 // Start/Stop
 @property (weak) IBOutlet NSButton *startStopButton;
 - (IBAction)startStopClicked:(id)sender;
+- (IBAction)stopServerWithShutdownClicked:(id)sender;
+- (IBAction)startAllServersClicked:(id)sender;
+- (IBAction)stopAllServersClicked:(id)sender;
+- (IBAction)restartAllServersClicked:(id)sender;
+- (IBAction)importServersClicked:(id)sender;
+- (IBAction)exportServersClicked:(id)sender;
 
 // Authorization
 @property (nonatomic, weak) IBOutlet SFAuthorizationView *authorizationView;
@@ -314,9 +371,11 @@
 
 // PGPrefsDelegate
 - (void)prefsController:(PGPrefsController *)controller willEditServerSettings:(PGServer *)server;
+- (void)prefsController:(PGPrefsController *)controller willViewLog:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServers:(NSArray *)servers;
 - (void)prefsController:(PGPrefsController *)controller didChangeSelectedServer:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerStatus:(PGServer *)server;
+- (void)prefsController:(PGPrefsController *)controller didChangeServerUsage:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerSetting:(NSString *)setting server:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didChangeServerSettings:(PGServer *)server;
 - (void)prefsController:(PGPrefsController *)controller didApplyServerSettings:(PGServer *)server;
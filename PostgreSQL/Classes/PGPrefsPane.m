@@ -32,6 +32,10 @@ NSInteger const PGDeleteServerCancelButton = 1234;
 NSInteger const PGDeleteServerKeepFileButton = 2345;
 NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
+/// Height of the servers filter field, and gap between it and the servers table
+static const CGFloat PGPrefsServersFilterHeight = 19;
+static const CGFloat PGPrefsServersFilterSpacing = 6;
+
 
 
 #pragma mark - Interfaces
@@ -67,6 +71,20 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 - (instancetype)initWithView:(NSView *)view;
 @end
 
+/**
+ * The parts of a server's status that are shown in the GUI, used to skip redrawing
+ * servers whose status hasn't visibly changed.
+ */
+@interface PGPrefsServerState : NSObject
+@property (nonatomic, readonly) PGServerStatus status;
+@property (nonatomic, readonly) NSInteger pid;
+@property (nonatomic, readonly) BOOL processing;
+@property (nonatomic, strong, readonly) NSString *error;
+@property (nonatomic, readonly) NSInteger errorDomain;
+- (instancetype)initWithServer:(PGServer *)server;
+- (BOOL)isEqualToState:(PGPrefsServerState *)state;
+@end
+
 @interface PGPrefsToggleImageView ()
 @property PGPrefsHiddenConstraints *hiddenConstraints;
 @end
@@ -79,6 +97,8 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
 /// If YES, user events will not be sent to the controller (e.g. select server)
 @property (nonatomic) BOOL updatingDisplay;
+/// If YES, the user asked for the server being selected (e.g. added it), so the filter is cleared if it hides the server
+@property (nonatomic) BOOL revealingSelectedServer;
 /// If NO, then all user controls will be greyed-out
 @property (nonatomic) BOOL enabled;
 /// If NO, then the start/stop button will be greyed-out
@@ -89,8 +109,17 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 @property (nonatomic) BOOL editEnabled;
 /// Used to darken background when showing authorization popover.
 @property (nonatomic) NSView *authorizationModalMask;
+/// Servers with status changes not yet shown. Flushed at most once per display frame.
+@property (nonatomic, strong) NSMutableOrderedSet<PGServer *> *pendingStatusChanges;
+/// The last status shown for each server, by server uid
+@property (nonatomic, strong) NSMutableDictionary<NSString *, PGPrefsServerState *> *shownStatuses;
+/// All servers from the controller. Only those matching the filter are in servers, and shown in the table.
+@property (nonatomic, strong) NSArray<PGServer *> *allServers;
+/// Lowercased words from the servers filter field, all of which must match
+@property (nonatomic, strong) NSArray<NSString *> *serversFilterTerms;
 
 - (void)initAuthorization;
+- (void)initServersFilter;
 
 - (void)showStatusWithName:(NSString *)name colour:(NSColor *)colour image:(NSString *)image info:(NSString *)info startStopButton:(NSString *)startStopButton;
 - (void)showStarted;
@@ -108,6 +137,12 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 - (void)showStatusInMainServerView:(PGServer *)server;
 - (void)showServerInMainServerView:(PGServer *)server;
 - (void)showServerInServersTable:(PGServer *)server;
+- (void)showPendingStatusChanges;
+- (void)showFilteredServers;
+- (BOOL)server:(PGServer *)server matchesFilterTerms:(NSArray<NSString *> *)terms;
+- (void)updateTableView:(NSTableView *)tableView rowOffset:(NSUInteger)offset fromServers:(NSArray<PGServer *> *)oldServers toServers:(NSArray<PGServer *> *)newServers;
+- (void)initUsageSparklines;
+- (void)showUsageInMainServerView:(PGServer *)server;
 - (void)showServerRenameWindow:(PGServer *)server;
 - (void)showServerSettingsWindow:(PGServer *)server;
 - (void)showServerDeleteWindow:(PGServer *)server;
@@ -406,6 +441,30 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 }
 @end
 
+@implementation PGPrefsServerState
+- (instancetype)initWithServer:(PGServer *)server
+{
+    self = [super init];
+    if (self) {
+        _status = server.status;
+        _pid = server.pid;
+        _processing = server.processing;
+        _error = server.error;
+        _errorDomain = server.errorDomain;
+    }
+    return self;
+}
+- (BOOL)isEqualToState:(PGPrefsServerState *)state
+{
+    if (!state) return NO;
+    return _status == state.status &&
+           _pid == state.pid &&
+           _processing == state.processing &&
+           _errorDomain == state.errorDomain &&
+           BothNilOrEqual(_error, state.error);
+}
+@end
+
 @implementation PGPrefsToggleEventsView
 - (NSView *)hitTest:(NSPoint)point
 {
@@ -457,6 +516,274 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
 
 
+#pragma mark - PGPrefsLogWindow
+
+/// Severity filters, in the order shown in the popup
+static const PGLogSeverity PGPrefsLogSeverityFilters[] = { PGLogSeverityNone, PGLogSeverityWarning, PGLogSeverityError, PGLogSeverityFatal };
+/// Time filters in seconds, in the order shown in the popup
+static const NSTimeInterval PGPrefsLogTimeFilters[] = { 0, 60 * 60, 24 * 60 * 60, 7 * 24 * 60 * 60 };
+
+@interface PGPrefsLogWindow ()
+/// Lines shown, if not filtering by severity
+@property (nonatomic) NSRange filteredRange;
+/// Lines shown (NSUInteger), if filtering by severity
+@property (nonatomic, strong) NSData *filteredLines;
+@end
+
+@implementation PGPrefsLogWindow
+- (instancetype)initWithLogFile:(PGLogFile *)logFile
+{
+    self = [super initWithContentRect:NSMakeRect(0, 0, 640, 400) styleMask:NSWindowStyleMaskTitled | NSWindowStyleMaskResizable backing:NSBackingStoreBuffered defer:YES];
+    if (self) {
+        _logFile = logFile;
+        _logFile.delegate = self;
+        self.title = logFile.path.lastPathComponent;
+        self.minSize = NSMakeSize(520, 200);
+        self.releasedWhenClosed = NO;
+        
+        // Table - fixed row height, so scrolling doesn't depend on number of lines
+        _tableView = [[NSTableView alloc] initWithFrame:NSZeroRect];
+        NSTableColumn *column = [[NSTableColumn alloc] initWithIdentifier:@"LogLine"];
+        column.resizingMask = NSTableColumnAutoresizingMask;
+        [_tableView addTableColumn:column];
+        _tableView.headerView = nil;
+        _tableView.rowHeight = 14;
+        _tableView.intercellSpacing = NSMakeSize(0, 0);
+        _tableView.columnAutoresizingStyle = NSTableViewLastColumnOnlyAutoresizingStyle;
+        _tableView.allowsMultipleSelection = YES;
+        _tableView.dataSource = self;
+        _tableView.delegate = self;
+        
+        NSScrollView *scrollView = [[NSScrollView alloc] initWithFrame:NSZeroRect];
+        scrollView.documentView = _tableView;
+        scrollView.hasVerticalScroller = YES;
+        scrollView.borderType = NSBezelBorder;
+        
+        // Filters
+        _severityPopUp = [[NSPopUpButton alloc] initWithFrame:NSZeroRect pullsDown:NO];
+        [_severityPopUp addItemsWithTitles:@[@"All Messages", @"Warnings & Errors", @"Errors", @"Fatal & Panic"]];
+        _severityPopUp.controlSize = NSControlSizeSmall;
+        _severityPopUp.font = [NSFont systemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeSmall]];
+        _severityPopUp.target = self;
+        _severityPopUp.action = @selector(filterChanged:);
+        _timePopUp = [[NSPopUpButton alloc] initWithFrame:NSZeroRect pullsDown:NO];
+        [_timePopUp addItemsWithTitles:@[@"Any Time", @"Last Hour", @"Last 24 Hours", @"Last 7 Days"]];
+        _timePopUp.controlSize = NSControlSizeSmall;
+        _timePopUp.font = _severityPopUp.font;
+        _timePopUp.target = self;
+        _timePopUp.action = @selector(filterChanged:);
+        
+        // Buttons
+        _closeButton = [NSButton buttonWithTitle:@"Close" target:nil action:@selector(closeLogWindowClicked:)];
+        _closeButton.keyEquivalent = @"\r";
+        _consoleButton = [NSButton buttonWithTitle:@"Open in Console" target:nil action:@selector(viewLogInConsoleClicked:)];
+        _statusField = [NSTextField labelWithString:@"Loading..."];
+        _statusField.font = [NSFont systemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeSmall]];
+        _statusField.textColor = [NSColor secondaryLabelColor];
+        _statusField.lineBreakMode = NSLineBreakByTruncatingTail;
+        
+        // Layout
+        NSView *content = self.contentView;
+        for (NSView *view in @[scrollView, _severityPopUp, _timePopUp, _statusField, _consoleButton, _closeButton]) {
+            view.translatesAutoresizingMaskIntoConstraints = NO;
+            [content addSubview:view];
+        }
+        [_statusField setContentCompressionResistancePriority:NSLayoutPriorityDefaultLow forOrientation:NSLayoutConstraintOrientationHorizontal];
+        [NSLayoutConstraint activateConstraints:@[
+            [_severityPopUp.topAnchor constraintEqualToAnchor:content.topAnchor constant:12],
+            [_severityPopUp.leadingAnchor constraintEqualToAnchor:content.leadingAnchor constant:12],
+            [_timePopUp.centerYAnchor constraintEqualToAnchor:_severityPopUp.centerYAnchor],
+            [_timePopUp.leadingAnchor constraintEqualToAnchor:_severityPopUp.trailingAnchor constant:8],
+            [scrollView.topAnchor constraintEqualToAnchor:_severityPopUp.bottomAnchor constant:8],
+            [scrollView.leadingAnchor constraintEqualToAnchor:content.leadingAnchor constant:12],
+            [scrollView.trailingAnchor constraintEqualToAnchor:content.trailingAnchor constant:-12],
+            [_closeButton.topAnchor constraintEqualToAnchor:scrollView.bottomAnchor constant:12],
+            [_closeButton.trailingAnchor constraintEqualToAnchor:scrollView.trailingAnchor],
+            [_closeButton.bottomAnchor constraintEqualToAnchor:content.bottomAnchor constant:-12],
+            [_consoleButton.centerYAnchor constraintEqualToAnchor:_closeButton.centerYAnchor],
+            [_consoleButton.trailingAnchor constraintEqualToAnchor:_closeButton.leadingAnchor constant:-8],
+            [_statusField.centerYAnchor constraintEqualToAnchor:_closeButton.centerYAnchor],
+            [_statusField.leadingAnchor constraintEqualToAnchor:scrollView.leadingAnchor],
+            [_statusField.trailingAnchor constraintLessThanOrEqualToAnchor:_consoleButton.leadingAnchor constant:-8],
+        ]];
+    }
+    return self;
+}
+
+
+
+#pragma mark Filters
+
+- (PGLogSeverity)severityFilter
+{
+    return PGPrefsLogSeverityFilters[MAX(0, self.severityPopUp.indexOfSelectedItem)];
+}
+- (NSTimeInterval)timeFilter
+{
+    return PGPrefsLogTimeFilters[MAX(0, self.timePopUp.indexOfSelectedItem)];
+}
+- (BOOL)filtering
+{
+    return self.severityFilter != PGLogSeverityNone || self.timeFilter > 0;
+}
+- (IBAction)filterChanged:(id)sender
+{
+    [self updateFilter];
+    [self.tableView reloadData];
+    if (self.tableView.numberOfRows > 0) [self.tableView scrollRowToVisible:self.tableView.numberOfRows-1];
+    [self updateStatus];
+}
+- (void)updateFilter
+{
+    NSTimeInterval time = self.timeFilter;
+    self.filteredRange = time > 0 ?
+        [self.logFile linesFrom:[NSDate dateWithTimeIntervalSinceNow:-time] to:nil] :
+        NSMakeRange(0, self.logFile.lineCount);
+    
+    // Severity - copy line numbers out of index set, for constant-time lookup by row
+    PGLogSeverity severity = self.severityFilter;
+    if (severity == PGLogSeverityNone) {
+        self.filteredLines = nil;
+    } else {
+        NSIndexSet *lines = [self.logFile linesWithSeverity:severity inRange:self.filteredRange];
+        NSMutableData *filteredLines = [NSMutableData dataWithLength:lines.count * sizeof(NSUInteger)];
+        [lines getIndexes:filteredLines.mutableBytes maxCount:lines.count inIndexRange:nil];
+        self.filteredLines = filteredLines;
+    }
+}
+- (NSUInteger)lineForRow:(NSInteger)row
+{
+    if (self.filteredLines) return ((const NSUInteger *)self.filteredLines.bytes)[row];
+    return self.filteredRange.location + (NSUInteger)row;
+}
+- (void)updateStatus
+{
+    NSUInteger lineCount = self.logFile.lineCount;
+    NSString *status = [NSString stringWithFormat:@"%@ lines", [NSNumberFormatter localizedStringFromNumber:@(lineCount) numberStyle:NSNumberFormatterDecimalStyle]];
+    if (self.filtering) status = [NSString stringWithFormat:@"%@ of %@", [NSNumberFormatter localizedStringFromNumber:@(self.tableView.numberOfRows) numberStyle:NSNumberFormatterDecimalStyle], status];
+    if (!self.logFile.indexed) status = [status stringByAppendingString:@" (loading...)"];
+    self.statusField.stringValue = status;
+}
+
+
+
+#pragma mark NSTableViewDataSource
+
+- (NSInteger)numberOfRowsInTableView:(NSTableView *)tableView
+{
+    if (self.filteredLines) return (NSInteger)(self.filteredLines.length / sizeof(NSUInteger));
+    if (self.filtering) return (NSInteger)self.filteredRange.length;
+    return (NSInteger)self.logFile.lineCount;
+}
+- (NSView *)tableView:(NSTableView *)tableView viewForTableColumn:(NSTableColumn *)tableColumn row:(NSInteger)row
+{
+    NSTextField *result = [tableView makeViewWithIdentifier:@"LogLine" owner:self];
+    if (!result) {
+        result = [NSTextField labelWithString:@""];
+        result.identifier = @"LogLine";
+        result.font = [NSFont userFixedPitchFontOfSize:11];
+        result.lineBreakMode = NSLineBreakByTruncatingTail;
+        result.selectable = YES;
+    }
+    NSUInteger line = [self lineForRow:row];
+    result.stringValue = [self.logFile lineAtIndex:line] ?: @"";
+    
+    // Highlight problems
+    PGLogSeverity severity = [self.logFile severityOfLineAtIndex:line];
+    if (severity >= PGLogSeverityError) result.textColor = [NSColor systemRedColor];
+    else if (severity == PGLogSeverityWarning) result.textColor = [NSColor systemOrangeColor];
+    else result.textColor = [NSColor labelColor];
+    return result;
+}
+
+
+
+#pragma mark PGLogFileDelegate
+
+- (void)logFile:(PGLogFile *)logFile didChangeLineCount:(NSUInteger)lineCount
+{
+    // Follow end of log if already scrolled to bottom
+    NSRect visibleRect = self.tableView.visibleRect;
+    BOOL atBottom = NSMaxY(visibleRect) >= NSMaxY(self.tableView.bounds) - self.tableView.rowHeight;
+    NSInteger previousCount = self.tableView.numberOfRows;
+    
+    // Filtered - re-run query, only matching lines are visited so this is cheap
+    if (self.filtering) {
+        [self updateFilter];
+        [self.tableView reloadData];
+        
+    } else {
+        self.filteredRange = NSMakeRange(0, lineCount);
+        [self.tableView noteNumberOfRowsChanged];
+        
+        // Last line may have been incomplete
+        if (previousCount > 0 && previousCount <= (NSInteger)lineCount) {
+            [self.tableView reloadDataForRowIndexes:[NSIndexSet indexSetWithIndex:previousCount-1] columnIndexes:[NSIndexSet indexSetWithIndex:0]];
+        
+        // Truncated or replaced
+        } else if (previousCount > (NSInteger)lineCount) {
+            [self.tableView reloadData];
+        }
+    }
+    
+    NSInteger rows = self.tableView.numberOfRows;
+    if (atBottom && rows > 0) [self.tableView scrollRowToVisible:rows-1];
+    
+    [self updateStatus];
+}
+@end
+
+
+
+#pragma mark - PGPrefsSparklineView
+
+@implementation PGPrefsSparklineView
+- (void)setValues:(NSArray<NSNumber *> *)values
+{
+    _values = values;
+    self.needsDisplay = YES;
+}
+- (void)setLabel:(NSString *)label
+{
+    _label = label;
+    self.needsDisplay = YES;
+}
+- (void)drawRect:(NSRect)dirtyRect
+{
+    NSRect bounds = NSInsetRect(self.bounds, 1, 1);
+    
+    // Graph
+    if (self.values.count > 1) {
+        double scale = self.minimumScale;
+        for (NSNumber *value in self.values) scale = MAX(scale, value.doubleValue);
+        if (scale <= 0) scale = 1;
+        
+        // Always drawn full width, so a few samples don't look bunched up
+        CGFloat step = bounds.size.width / (self.values.count - 1);
+        NSBezierPath *path = [NSBezierPath bezierPath];
+        [self.values enumerateObjectsUsingBlock:^(NSNumber *value, NSUInteger idx, BOOL *stop) {
+            NSPoint point = NSMakePoint(NSMinX(bounds) + idx * step, NSMinY(bounds) + (value.doubleValue / scale) * bounds.size.height);
+            if (idx == 0) [path moveToPoint:point];
+            else [path lineToPoint:point];
+        }];
+        [(self.lineColor ?: PGServerInfoColor) setStroke];
+        path.lineWidth = 1;
+        [path stroke];
+    }
+    
+    // Latest value
+    if (self.label) {
+        NSDictionary *attributes = @{
+            NSFontAttributeName: [NSFont systemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeMini]],
+            NSForegroundColorAttributeName: [NSColor secondaryLabelColor]
+        };
+        [self.label drawAtPoint:NSMakePoint(NSMinX(bounds), NSMaxY(bounds) - 10) withAttributes:attributes];
+    }
+}
+@end
+
+
+
 #pragma mark - PGPrefsPane
 
 @implementation PGPrefsPane
@@ -475,6 +802,8 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     // Set servers menu
     [self.serversMenu setDelegate:self];
     [self.serversButtons setMenu:self.serversMenu forSegment:2];
+    [self addStopItemsToServersMenu];
+    [self addAllServersItemsToServersMenu];
 
     // Reset initial view states
     self.updatingDisplay = YES;
@@ -484,6 +813,10 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     self.enabled = YES;
     self.updatingDisplay = NO;
     
+    // Status changes
+    self.pendingStatusChanges = [NSMutableOrderedSet orderedSet];
+    self.shownStatuses = [NSMutableDictionary dictionary];
+    
     // Set new delegate
     self.controller = [[PGPrefsController alloc] initWithViewController:self];
     
@@ -497,6 +830,12 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     // Wire up authorization
     [self initAuthorization];
     
+    // Resource usage graphs
+    [self initUsageSparklines];
+    
+    // Type-ahead filter for the servers table
+    [self initServersFilter];
+    
     // Call delegate DidLoad method
     [self.controller viewDidLoad];
     
@@ -625,6 +964,17 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 {
     [self.controller userDidViewLog];
 }
+- (IBAction)viewLogInConsoleClicked:(id)sender
+{
+    [self closeLogWindowClicked:sender];
+    [self.controller userDidViewLogInConsole];
+}
+- (IBAction)closeLogWindowClicked:(id)sender
+{
+    if (!self.logWindow) return;
+    
+    [self.mainView.window endSheet:self.logWindow returnCode:NSModalResponseOK];
+}
 
 
 
@@ -796,7 +1146,9 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     
     switch (sender.selectedSegment) {
         case 0:
+            self.revealingSelectedServer = YES;
             [self.controller userDidAddServer];
+            self.revealingSelectedServer = NO;
             break;
         case 1:
             [self.controller userDidDeleteServer];
@@ -828,13 +1180,35 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
 - (IBAction)duplicateServerClicked:(id)sender
 {
+    self.revealingSelectedServer = YES;
     [self.controller userDidDuplicateServer];
+    self.revealingSelectedServer = NO;
 }
 
 - (IBAction)refreshServersClicked:(id)sender
 {
     [self.controller userDidRefreshServers];
 }
+
+- (IBAction)serversFilterChanged:(id)sender
+{
+    NSString *filter = [self.serversFilterField.stringValue lowercaseString];
+    NSArray<NSString *> *terms = [filter componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    terms = [terms filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"length > 0"]];
+    if ([terms isEqualToArray:self.serversFilterTerms ?: @[]]) return;
+    self.serversFilterTerms = terms.count > 0 ? terms : nil;
+    
+    PGServer *server = [self selectedServer];
+    
+    self.updatingDisplay = YES;
+    [self showFilteredServers];
+    self.updatingDisplay = NO;
+    
+    // Type-ahead - if the selected server is filtered out, select the first match instead
+    if (server && [self rowForServer:server] != NSNotFound) return;
+    PGServer *match = self.servers.firstObject;
+    if (match) [self.controller userDidSelectServer:match];
+}
      
 - (void)menuWillOpen:(NSMenu *)menu
 {
@@ -850,6 +1224,84 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 {
     [self.controller userDidStartStopServer];
 }
+- (IBAction)stopServerWithShutdownClicked:(id)sender
+{
+    [self.controller userDidStopServerWithShutdown:[sender tag]];
+}
+- (void)addStopItemsToServersMenu
+{
+    [self.serversMenu addItem:[NSMenuItem separatorItem]];
+    NSMenuItem *fast = [self.serversMenu addItemWithTitle:@"Stop Server (Fast)" action:@selector(stopServerWithShutdownClicked:) keyEquivalent:@""];
+    fast.target = self;
+    fast.tag = PGServerShutdownFast;
+    NSMenuItem *immediate = [self.serversMenu addItemWithTitle:@"Stop Server (Immediate)" action:@selector(stopServerWithShutdownClicked:) keyEquivalent:@""];
+    immediate.target = self;
+    immediate.tag = PGServerShutdownImmediate;
+}
+- (IBAction)startAllServersClicked:(id)sender
+{
+    [self.controller userDidStartAllServers];
+}
+- (IBAction)stopAllServersClicked:(id)sender
+{
+    [self.controller userDidStopAllServers];
+}
+- (IBAction)restartAllServersClicked:(id)sender
+{
+    [self.controller userDidRestartAllServers];
+}
+- (void)addAllServersItemsToServersMenu
+{
+    [self.serversMenu addItem:[NSMenuItem separatorItem]];
+    [[self.serversMenu addItemWithTitle:@"Start All Servers" action:@selector(startAllServersClicked:) keyEquivalent:@""] setTarget:self];
+    [[self.serversMenu addItemWithTitle:@"Stop All Servers" action:@selector(stopAllServersClicked:) keyEquivalent:@""] setTarget:self];
+    [[self.serversMenu addItemWithTitle:@"Restart All Servers" action:@selector(restartAllServersClicked:) keyEquivalent:@""] setTarget:self];
+    [self.serversMenu addItem:[NSMenuItem separatorItem]];
+    [[self.serversMenu addItemWithTitle:@"Import Servers\u2026" action:@selector(importServersClicked:) keyEquivalent:@""] setTarget:self];
+    [[self.serversMenu addItemWithTitle:@"Export Servers\u2026" action:@selector(exportServersClicked:) keyEquivalent:@""] setTarget:self];
+}
+- (IBAction)importServersClicked:(id)sender
+{
+    NSOpenPanel *panel = [NSOpenPanel openPanel];
+    panel.allowedFileTypes = @[@"jsonl", @"json"];
+    panel.allowsOtherFileTypes = YES;
+    panel.message = @"Choose a server list, with one JSON object per line";
+    weakify(self);
+    [panel beginSheetModalForWindow:self.mainView.window completionHandler:^(NSModalResponse result) {
+        strongify(self);
+        if (result != NSModalResponseOK) return;
+        [self.controller userDidImportServersFromFile:panel.URL.path completion:^(BOOL imported, NSString *error) {
+            if (!imported) {
+                [self showImportExportError:error title:@"Cannot import servers"];
+            } else if (error) {
+                [self showImportExportError:error title:@"Some servers were not imported"];
+            }
+        }];
+    }];
+}
+- (IBAction)exportServersClicked:(id)sender
+{
+    NSSavePanel *panel = [NSSavePanel savePanel];
+    panel.allowedFileTypes = @[@"jsonl"];
+    panel.nameFieldStringValue = @"Servers.jsonl";
+    weakify(self);
+    [panel beginSheetModalForWindow:self.mainView.window completionHandler:^(NSModalResponse result) {
+        strongify(self);
+        if (result != NSModalResponseOK) return;
+        NSString *error = nil;
+        if (![self.controller userDidExportServersToFile:panel.URL.path error:&error]) {
+            [self showImportExportError:error title:@"Cannot export servers"];
+        }
+    }];
+}
+- (void)showImportExportError:(NSString *)error title:(NSString *)title
+{
+    NSAlert *alert = [[NSAlert alloc] init];
+    alert.alertStyle = NSAlertStyleWarning;
+    alert.messageText = title;
+    alert.informativeText = error ?: @"Unknown error";
+    [alert beginSheetModalForWindow:self.mainView.window completionHandler:nil];
+}
 
 
 
@@ -1043,6 +1495,10 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 {
     [self showServerSettingsWindow:server];
 }
+- (void)prefsController:(PGPrefsController *)controller willViewLog:(PGServer *)server
+{
+    [self showLogWindow:server];
+}
 - (void)prefsController:(PGPrefsController *)controller didChangeServers:(NSArray *)servers
 {
     self.updatingDisplay = YES;
@@ -1050,10 +1506,16 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     DLog(@"Servers: %@", @(servers.count));
     
     PGServer *server = [self selectedServer];
-    self.servers = servers;
-    [self.serversTableView reloadData];
+    self.allServers = servers;
+    [self showFilteredServers];
     [self selectServer:server];
     
+    // Forget deleted servers
+    NSSet *uids = [NSSet setWithArray:[servers valueForKey:@"uid"] ?: @[]];
+    for (NSString *uid in self.shownStatuses.allKeys) {
+        if (![uids containsObject:uid]) [self.shownStatuses removeObjectForKey:uid];
+    }
+    
     self.updatingDisplay = NO;
 }
 
@@ -1069,13 +1531,25 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
 - (void)prefsController:(PGPrefsController *)controller didChangeServerStatus:(PGServer *)server
 {
-    self.updatingDisplay = YES;
+    if (!server) return;
     
-    if ([self selectedServer] == server) [self showStatusInMainServerView:server];
+    // Batch changes, and show at most once per display frame
+    BOOL scheduled = self.pendingStatusChanges.count > 0;
+    [self.pendingStatusChanges addObject:server];
+    if (scheduled) return;
     
-    [self showServerInServersTable:server];
+    weakify(self);
+    MainThreadAfterDelay(PGPrefsDisplayFrameTime, ^{
+        strongify(self);
+        [self showPendingStatusChanges];
+    });
+}
+
+- (void)prefsController:(PGPrefsController *)controller didChangeServerUsage:(PGServer *)server
+{
+    if ([self selectedServer] != server) return;
     
-    self.updatingDisplay = NO;
+    [self showUsageInMainServerView:server];
 }
 
 - (void)prefsController:(PGPrefsController *)controller didChangeServerSetting:(NSString *)setting server:(PGServer *)server
@@ -1133,10 +1607,16 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     
     if (sortDescriptors.count == 0) sortDescriptors = @[[NSSortDescriptor sortDescriptorWithKey:@"shortName" ascending:YES]];
     
+    NSArray *oldServers = self.searchServers;
     self.searchServers = [servers sortedArrayUsingDescriptors:sortDescriptors];
-    self.serverSettingsWindow.serversTableView.sortDescriptors = sortDescriptors;
     
-    [self.serverSettingsWindow.serversTableView reloadData];
+    // Changing sort descriptors reloads the whole table anyway
+    if (![self.serverSettingsWindow.serversTableView.sortDescriptors isEqualToArray:sortDescriptors]) {
+        self.serverSettingsWindow.serversTableView.sortDescriptors = sortDescriptors;
+        [self.serverSettingsWindow.serversTableView reloadData];
+    } else {
+        [self updateTableView:self.serverSettingsWindow.serversTableView rowOffset:0 fromServers:oldServers toServers:self.searchServers];
+    }
     
     self.updatingDisplay = NO;
 }
@@ -1172,11 +1652,25 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
 
 - (void)selectServer:(PGServer *)server
 {
+    // Hidden by the filter - show all servers again if the user asked for this server
+    if (self.revealingSelectedServer && server && self.serversFilterTerms && ![self.servers containsObject:server] && [self.allServers containsObject:server]) {
+        self.serversFilterField.stringValue = @"";
+        self.serversFilterTerms = nil;
+        [self showFilteredServers];
+    }
+    
+    // Otherwise keep the filter, and show nothing selected
     NSUInteger row = [self.servers indexOfObject:server];
-    if (row == NSNotFound) return;
+    if (row == NSNotFound) {
+        [self.serversTableView deselectAll:nil];
+        return;
+    }
     
     [self.serversTableView selectRowIndexes:[NSIndexSet indexSetWithIndex:row+1] byExtendingSelection:NO];
     
+    // Don't interrupt typing in the filter
+    if (self.serversFilterField.currentEditor) return;
+    
     [self.mainView.window makeFirstResponder:self.serversTableView];
 }
 
@@ -1384,6 +1878,9 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     self.editEnabled = server.editable;
     self.startStopEnabled = server.actionable;
     
+    // Boot daemons' logs aren't rotated, as that would need a password in the background
+    self.viewLogButton.toolTip = server.daemonLogUnmanaged ? [NSString stringWithFormat:@"Log not rotated automatically - %@ is only writable by administrators", [server.daemonLog.stringByDeletingLastPathComponent stringByAbbreviatingWithTildeInPath]] : nil;
+    
     self.startStopButton.hidden = server.status == PGServerStatusUnknown;
     self.enabled = !server.processing;
     
@@ -1422,6 +1919,212 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
         
         [self showSettingsInMainServerView:server];
         [self showStatusInMainServerView:server];
+        [self showUsageInMainServerView:server];
+    }
+}
+
+- (void)initUsageSparklines
+{
+    // Fit between the View Log and Change Settings buttons
+    NSView *container = self.viewLogButton.superview;
+    NSRect left = self.viewLogButton.frame;
+    NSRect right = self.changeSettingsButton.frame;
+    CGFloat spacing = 4;
+    CGFloat x = NSMaxX(left) + spacing;
+    CGFloat width = (NSMinX(right) - spacing - x - 3 * spacing) / 4;
+    if (!container || width <= 0) return;
+    
+    NSMutableArray<PGPrefsSparklineView *> *sparklines = [NSMutableArray arrayWithCapacity:4];
+    for (NSUInteger i = 0; i < 4; i++) {
+        NSRect frame = NSMakeRect(x + i * (width + spacing), NSMinY(left) + 6, width, NSHeight(left) - 10);
+        PGPrefsSparklineView *sparkline = [[PGPrefsSparklineView alloc] initWithFrame:frame];
+        sparkline.autoresizingMask = NSViewMinXMargin | NSViewMaxXMargin;
+        sparkline.hidden = YES;
+        [container addSubview:sparkline];
+        [sparklines addObject:sparkline];
+    }
+    
+    self.cpuSparkline = sparklines[0];
+    self.cpuSparkline.minimumScale = 10;
+    self.memorySparkline = sparklines[1];
+    self.memorySparkline.minimumScale = 16 * 1024 * 1024;
+    self.filesSparkline = sparklines[2];
+    self.filesSparkline.minimumScale = 10;
+    self.backendsSparkline = sparklines[3];
+    self.backendsSparkline.minimumScale = 5;
+}
+
+- (void)initServersFilter
+{
+    // Take space from the top of the servers table
+    NSScrollView *scrollView = self.serversTableView.enclosingScrollView;
+    NSView *container = scrollView.superview;
+    if (!container) return;
+    
+    NSRect frame = scrollView.frame;
+    NSRect filterFrame = NSMakeRect(NSMinX(frame), NSMaxY(frame) - PGPrefsServersFilterHeight, NSWidth(frame), PGPrefsServersFilterHeight);
+    frame.size.height -= PGPrefsServersFilterHeight + PGPrefsServersFilterSpacing;
+    scrollView.frame = frame;
+    
+    NSSearchField *filter = [[NSSearchField alloc] initWithFrame:filterFrame];
+    filter.autoresizingMask = scrollView.autoresizingMask;
+    filter.controlSize = NSControlSizeSmall;
+    filter.font = [NSFont systemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeSmall]];
+    filter.placeholderString = @"Name, port or data directory";
+    filter.sendsSearchStringImmediately = YES;
+    filter.sendsWholeSearchString = NO;
+    filter.target = self;
+    filter.action = @selector(serversFilterChanged:);
+    [container addSubview:filter];
+    self.serversFilterField = filter;
+}
+
+- (void)showUsageInMainServerView:(PGServer *)server
+{
+    NSMutableArray *cpu = [NSMutableArray arrayWithCapacity:server.usageHistory.count];
+    NSMutableArray *memory = [NSMutableArray arrayWithCapacity:server.usageHistory.count];
+    NSMutableArray *files = [NSMutableArray arrayWithCapacity:server.usageHistory.count];
+    NSMutableArray *backends = [NSMutableArray arrayWithCapacity:server.usageHistory.count];
+    [server.usageHistory enumerateUsageUsingBlock:^(PGProcessUsage usage) {
+        [cpu addObject:@(usage.cpuPercent)];
+        [memory addObject:@(usage.residentBytes)];
+        [files addObject:@(usage.openFiles)];
+        [backends addObject:@(usage.children)];
+    }];
+    
+    // Hide if not running
+    BOOL hidden = cpu.count == 0;
+    self.cpuSparkline.hidden = hidden;
+    self.memorySparkline.hidden = hidden;
+    self.filesSparkline.hidden = hidden;
+    self.backendsSparkline.hidden = hidden;
+    if (hidden) return;
+    
+    PGProcessUsage latest;
+    [server.usageHistory latestUsage:&latest];
+    NSString *memoryLabel = [NSByteCountFormatter stringFromByteCount:(long long)latest.residentBytes countStyle:NSByteCountFormatterCountStyleMemory];
+    
+    self.cpuSparkline.values = cpu;
+    self.cpuSparkline.label = [NSString stringWithFormat:@"%.0f%%", latest.cpuPercent];
+    self.cpuSparkline.toolTip = [NSString stringWithFormat:@"CPU: %.1f%%", latest.cpuPercent];
+    self.memorySparkline.values = memory;
+    self.memorySparkline.label = [NSString stringWithFormat:@"%.0fM", latest.residentBytes / (1024.0 * 1024.0)];
+    self.memorySparkline.toolTip = [NSString stringWithFormat:@"Memory: %@", memoryLabel];
+    self.filesSparkline.values = files;
+    self.filesSparkline.label = [NSString stringWithFormat:@"%@", @(latest.openFiles)];
+    self.filesSparkline.toolTip = [NSString stringWithFormat:@"Open files: %@", @(latest.openFiles)];
+    self.backendsSparkline.values = backends;
+    self.backendsSparkline.label = [NSString stringWithFormat:@"%@", @(latest.children)];
+    self.backendsSparkline.toolTip = [NSString stringWithFormat:@"Backend processes: %@", @(latest.children)];
+}
+
+- (void)showPendingStatusChanges
+{
+    NSArray<PGServer *> *servers = self.pendingStatusChanges.array;
+    [self.pendingStatusChanges removeAllObjects];
+    
+    self.updatingDisplay = YES;
+    
+    NSMutableIndexSet *rows = [NSMutableIndexSet indexSet];
+    for (PGServer *server in servers) {
+        
+        // Skip if nothing visible has changed
+        PGPrefsServerState *state = [[PGPrefsServerState alloc] initWithServer:server];
+        if ([state isEqualToState:self.shownStatuses[server.uid]]) continue;
+        self.shownStatuses[server.uid] = state;
+        
+        if ([self selectedServer] == server) [self showStatusInMainServerView:server];
+        
+        NSUInteger row = [self rowForServer:server];
+        if (row != NSNotFound) [rows addIndex:row];
+    }
+    
+    // Single reload for all changed rows
+    if (rows.count > 0) {
+        [self.serversTableView reloadDataForRowIndexes:rows columnIndexes:[NSIndexSet indexSetWithIndex:0]];
+    }
+    
+    self.updatingDisplay = NO;
+}
+
+- (void)showFilteredServers
+{
+    NSArray<PGServer *> *servers = self.allServers ?: @[];
+    NSArray<NSString *> *terms = self.serversFilterTerms;
+    if (terms) {
+        NSMutableArray<PGServer *> *matches = [NSMutableArray arrayWithCapacity:servers.count];
+        for (PGServer *server in servers) {
+            if ([self server:server matchesFilterTerms:terms]) [matches addObject:server];
+        }
+        servers = matches;
+    }
+    
+    NSArray<PGServer *> *oldServers = self.servers;
+    self.servers = servers;
+    [self updateTableView:self.serversTableView rowOffset:1 fromServers:oldServers toServers:servers];
+}
+
+- (BOOL)server:(PGServer *)server matchesFilterTerms:(NSArray<NSString *> *)terms
+{
+    NSStringCompareOptions options = NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch;
+    for (NSString *term in terms) {
+        if ([server.shortName rangeOfString:term options:options].location != NSNotFound) continue;
+        if ([server.settings.port rangeOfString:term options:options].location != NSNotFound) continue;
+        if ([server.settings.dataDirectory rangeOfString:term options:options].location != NSNotFound) continue;
+        return NO;
+    }
+    return YES;
+}
+
+/**
+ * Applies the difference between the old and new servers as row removes and inserts, matching
+ * servers by uid, so unchanged rows keep their views. Only the visible unchanged rows are
+ * refreshed. If the matched servers have changed order, falls back to reloading everything.
+ */
+- (void)updateTableView:(NSTableView *)tableView rowOffset:(NSUInteger)offset fromServers:(NSArray<PGServer *> *)oldServers toServers:(NSArray<PGServer *> *)newServers
+{
+    NSMutableDictionary<NSString *, NSNumber *> *newIndexes = [NSMutableDictionary dictionaryWithCapacity:newServers.count];
+    [newServers enumerateObjectsUsingBlock:^(PGServer *server, NSUInteger index, BOOL *stop) {
+        newIndexes[server.uid] = @(index);
+    }];
+    
+    // Removed, and check matched servers are in the same order
+    NSMutableIndexSet *removed = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *matched = [NSMutableIndexSet indexSet];
+    NSInteger previous = -1;
+    for (NSUInteger i = 0; i < oldServers.count; i++) {
+        NSNumber *index = newIndexes[oldServers[i].uid];
+        if (!index) {
+            [removed addIndex:i+offset];
+            continue;
+        }
+        if (index.integerValue < previous) {
+            [tableView reloadData];
+            return;
+        }
+        previous = index.integerValue;
+        [matched addIndex:index.unsignedIntegerValue+offset];
+    }
+    
+    // Inserted
+    NSMutableIndexSet *inserted = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(offset, newServers.count)];
+    [inserted removeIndexes:matched];
+    
+    if (removed.count > 0 || inserted.count > 0) {
+        [tableView beginUpdates];
+        [tableView removeRowsAtIndexes:removed withAnimation:NSTableViewAnimationEffectNone];
+        [tableView insertRowsAtIndexes:inserted withAnimation:NSTableViewAnimationEffectNone];
+        [tableView endUpdates];
+    }
+    
+    // Matched servers may have changed e.g. name, but only rows on screen have views
+    NSRange visible = [tableView rowsInRect:tableView.visibleRect];
+    NSMutableIndexSet *refresh = [NSMutableIndexSet indexSet];
+    [matched enumerateIndexesInRange:visible options:0 usingBlock:^(NSUInteger row, BOOL *stop) {
+        [refresh addIndex:row];
+    }];
+    if (refresh.count > 0) {
+        [tableView reloadDataForRowIndexes:refresh columnIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, tableView.numberOfColumns)]];
     }
 }
 
@@ -1511,6 +2214,26 @@ NSInteger const PGDeleteServerDeleteFileButton = 3456;
     [self.deleteServerWindow orderFront:self];
 }
 
+- (void)showLogWindow:(PGServer *)server
+{
+    if (self.logWindow) return;
+    
+    PGLogFile *logFile = [[PGLogFile alloc] initWithPath:server.daemonLog];
+    self.logWindow = [[PGPrefsLogWindow alloc] initWithLogFile:logFile];
+    self.logWindow.closeButton.target = self;
+    self.logWindow.consoleButton.target = self;
+    [logFile open];
+    
+    weakify(self);
+    [self.mainView.window beginSheet:self.logWindow completionHandler:^(NSModalResponse returnCode) {
+        strongify(self);
+        
+        [self.logWindow.logFile close];
+        [self.logWindow orderOut:self];
+        self.logWindow = nil;
+    }];
+}
+
 - (void)showInfoWindow:(PGPrefsInfoWindow *)window
 {
     weakify(self);
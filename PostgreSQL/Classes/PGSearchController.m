@@ -35,6 +35,7 @@
 /// Last time search was run. Used to prevent search being run too frequently.
 @property (nonatomic, strong) NSDate *lastUpdated;
 
+#ifdef __APPLE__
 @property (nonatomic, strong) NSMetadataQuery *enterpriseDBQuery;
 @property (nonatomic, strong) NSMetadataQuery *postgresappQuery;
 @property (nonatomic, strong) NSMetadataQuery *spotlightQuery;
@@ -68,6 +69,7 @@
  * Callback for NSNotificationCenter query event
  */
 - (void)initialGatherComplete:(NSNotification *)notification;
+#endif
 
 
 /**
@@ -102,6 +104,7 @@
 {
     return _mutableServers;
 }
+#ifdef __APPLE__
 - (void)setEnterpriseDBQuery:(NSMetadataQuery *)enterpriseDBQuery
 {
     if (enterpriseDBQuery == _enterpriseDBQuery) return;
@@ -140,6 +143,7 @@
     [[NSNotificationCenter defaultCenter] removeObserver:self name:NSMetadataQueryDidUpdateNotification object:query];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:NSMetadataQueryDidFinishGatheringNotification object:query];
 }
+#endif
 
 
 
@@ -154,9 +158,13 @@
     [self.mutableServers removeAllObjects];
 
     DLog(@"Find servers...");
+#ifdef __APPLE__
     [self findServersFromSpotlight];
     [self findServersFromPostgresapp];
     [self findServersFromEnterpriseDB];
+#else
+    // No Spotlight - only started servers can be found
+#endif
 }
 
 - (NSArray *)startedServers
@@ -212,12 +220,12 @@
         if (server) { numberOfServers++; }
     }
     
-#ifdef DEBUG
-    DLog(@"Postgres Processes:\n%@\n\nOther Processes:\n%@",
-         [processes objectsAtIndexes:[servers indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) { return obj != [NSNull null]; }]],
-         [processes objectsAtIndexes:[servers indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) { return obj == [NSNull null]; }]]
-    );
-#endif
+    if (IsLogging) {
+        DLog(@"Postgres Processes:\n%@\n\nOther Processes:\n%@",
+             [processes objectsAtIndexes:[servers indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) { return obj != [NSNull null]; }]],
+             [processes objectsAtIndexes:[servers indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) { return obj == [NSNull null]; }]]
+        );
+    }
     
     return numberOfServers == 0 ? nil : [servers filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(id obj, NSDictionary *bindings) { return obj != [NSNull null]; }]];
 }
@@ -239,6 +247,7 @@
     }
 }
 
+#ifdef __APPLE__
 - (void)findServersFromEnterpriseDB
 {
     NSMetadataQuery *query = [[NSMetadataQuery alloc] init];
@@ -272,6 +281,7 @@
     self.spotlightQuery = query;
     [query startQuery];
 }
+#endif
 
 - (NSArray *)serversFromEnterpriseDBFiles:(NSArray *)files
 {
@@ -381,6 +391,7 @@
 
 
 
+#ifdef __APPLE__
 #pragma mark NSMetadataQuery
 
 - (void)queryDidUpdate:(NSNotification *)notification
@@ -432,6 +443,7 @@
         [self.delegate didFindMoreServers:self];
     });
 }
+#endif
 
 
 
@@ -26,6 +26,8 @@
 
 #import <Foundation/Foundation.h>
 #import "PGFile.h"
+#import "PGProcess.h"
+#import "PGLogRotator.h"
 
 #pragma mark - Constants/Utilities
 
@@ -40,6 +42,14 @@ extern NSString *const PGServerDataDirectoryKey;
 extern NSString *const PGServerLogFileKey;
 extern NSString *const PGServerPortKey;
 extern NSString *const PGServerStartupKey;
+/// Optional log rotation keys - megabytes, hours, megabytes
+extern NSString *const PGServerLogMaxSizeKey;
+extern NSString *const PGServerLogMaxAgeKey;
+extern NSString *const PGServerLogMaxTotalSizeKey;
+/// Optional stop keys - shutdown mode name, boolean, seconds
+extern NSString *const PGServerShutdownKey;
+extern NSString *const PGServerCheckpointBeforeStopKey;
+extern NSString *const PGServerShutdownTimeoutKey;
 
 extern NSString *const PGServerStatusUnknownName;
 extern NSString *const PGServerStartingName;
@@ -54,12 +64,23 @@ extern NSString *const PGServerStartupManualName;
 extern NSString *const PGServerStartupAtBootName;
 extern NSString *const PGServerStartupAtLoginName;
 
+extern NSString *const PGServerShutdownSmartName;
+extern NSString *const PGServerShutdownFastName;
+extern NSString *const PGServerShutdownImmediateName;
+
 typedef NS_ENUM(NSInteger, PGServerStartup) {
     PGServerStartupManual = 0,
     PGServerStartupAtBoot,
     PGServerStartupAtLogin
 };
 
+/// Postgres shutdown modes, in order of escalation - SIGTERM, SIGINT, SIGQUIT
+typedef NS_ENUM(NSInteger, PGServerShutdown) {
+    PGServerShutdownSmart = 0,
+    PGServerShutdownFast,
+    PGServerShutdownImmediate
+};
+
 typedef NS_ENUM(NSInteger, PGServerStatus) {
     PGServerStatusUnknown = 0,
     PGServerStarting,
@@ -112,6 +133,32 @@ NSStringFromPGServerStartup(PGServerStartup value)
     }
 }
 
+static inline PGServerShutdown
+ToServerShutdown(id value)
+{
+    // Nil
+    if (value == nil || value == [NSNull null]) return PGServerShutdownSmart;
+    
+    // Number
+    if ([value isKindOfClass:[NSNumber class]]) return MIN(MAX([((NSNumber *) value) integerValue], PGServerShutdownSmart), PGServerShutdownImmediate);
+    
+    // String
+    NSString *description = [[value description] lowercaseString];
+    if ([description isEqualToString:[PGServerShutdownFastName lowercaseString]]) return PGServerShutdownFast;
+    else if ([description isEqualToString:[PGServerShutdownImmediateName lowercaseString]]) return PGServerShutdownImmediate;
+    else return PGServerShutdownSmart;
+}
+
+static inline NSString *
+NSStringFromPGServerShutdown(PGServerShutdown value)
+{
+    switch (value) {
+        case PGServerShutdownFast: return PGServerShutdownFastName;
+        case PGServerShutdownImmediate: return PGServerShutdownImmediateName;
+        default: return PGServerShutdownSmartName;
+    }
+}
+
 
 
 #pragma mark - PGServerSettings
@@ -201,6 +248,12 @@ NSStringFromPGServerStartup(PGServerStartup value)
 /// If YES, this server is starting or stopping
 @property (nonatomic) BOOL processing;
 
+/// Seconds spent waiting for the server to stop or start during the last action
+@property (nonatomic) NSTimeInterval waitTime;
+
+/// Recent resource usage samples of the server's processes, oldest first
+@property (nonatomic, strong, readonly) PGProcessUsageHistory *usageHistory;
+
 /// If YES, this server is started or retrying
 @property (nonatomic, readonly) BOOL started;
 
@@ -248,6 +301,24 @@ NSStringFromPGServerStartup(PGServerStartup value)
 /// If YES, the daemon log file exists
 @property (nonatomic, readonly) BOOL daemonLogExists;
 
+/// When to rotate the daemon log, and how much to keep. Defaults to the app-wide policy.
+@property (nonatomic) PGLogRotationPolicy logRotation;
+
+/// If YES, the daemon log can't be rotated without authorization, e.g. a boot daemon's log, so grows until the user deals with it
+@property (nonatomic) BOOL daemonLogUnmanaged;
+
+/// How to stop the server, unless overridden for a single stop. Defaults to smart.
+@property (nonatomic) PGServerShutdown shutdown;
+
+/// If YES, a CHECKPOINT is run before stopping, so the next start has less to recover
+@property (nonatomic) BOOL checkpointBeforeStop;
+
+/// Seconds to wait for each shutdown mode before escalating to the next
+@property (nonatomic) NSTimeInterval shutdownTimeout;
+
+/// Seconds spent in each phase of the last stop, keyed by phase name - Checkpoint, Smart, Fast, Immediate
+@property (nonatomic, strong) NSDictionary<NSString *, NSNumber *> *stopPhaseTimes;
+
 /// If NO, then this server is read-only - i.e. created outside of this tool
 @property (nonatomic, readonly) BOOL editable;
 
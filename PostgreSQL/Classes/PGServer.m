@@ -38,6 +38,12 @@ NSString *const PGServerDataDirectoryKey       = @"DataDirectory";
 NSString *const PGServerLogFileKey             = @"LogFile";
 NSString *const PGServerPortKey                = @"Port";
 NSString *const PGServerStartupKey             = @"Startup";
+NSString *const PGServerLogMaxSizeKey          = @"LogMaxSize";
+NSString *const PGServerLogMaxAgeKey           = @"LogMaxAge";
+NSString *const PGServerLogMaxTotalSizeKey     = @"LogMaxTotalSize";
+NSString *const PGServerShutdownKey            = @"Shutdown";
+NSString *const PGServerCheckpointBeforeStopKey = @"CheckpointBeforeStop";
+NSString *const PGServerShutdownTimeoutKey     = @"ShutdownTimeout";
 
 NSString *const PGServerStatusUnknownName      = @"Unknown";
 NSString *const PGServerStartingName           = @"Starting";
@@ -52,6 +58,10 @@ NSString *const PGServerStartupManualName      = @"Manual";
 NSString *const PGServerStartupAtBootName      = @"Boot";
 NSString *const PGServerStartupAtLoginName     = @"Login";
 
+NSString *const PGServerShutdownSmartName      = @"Smart";
+NSString *const PGServerShutdownFastName       = @"Fast";
+NSString *const PGServerShutdownImmediateName  = @"Immediate";
+
 
 
 #pragma mark - Interfaces
@@ -225,6 +235,9 @@ NSString *const PGServerStartupAtLoginName     = @"Login";
     self = [super init];
     if (self) {
         _uid = [PGUID uid];
+        _usageHistory = [[PGProcessUsageHistory alloc] initWithCapacity:PGServerUsageHistoryCapacity];
+        _logRotation = PGLogRotationPolicyMake(PGLogRotationMaxSize, PGLogRotationMaxAge, PGLogRotationMaxTotalSize);
+        _shutdownTimeout = PGServerShutdownTimeout;
         self.name = name;
         self.domain = domain;
         self.settings = settings;
@@ -258,14 +271,26 @@ NSString *const PGServerStartupAtLoginName     = @"Login";
 - (NSDictionary *)properties
 {
     PGServerSettings *settings = self.settings;
-    return @{
+    NSMutableDictionary *result = [@{
              PGServerUsernameKey:settings.username?:@"",
              PGServerBinDirectoryKey:settings.binDirectory?:@"",
              PGServerDataDirectoryKey:settings.dataDirectory?:@"",
              PGServerLogFileKey:settings.logFile?:@"",
              PGServerPortKey:settings.port?:@"",
              PGServerStartupKey:NSStringFromPGServerStartup(settings.startup)
-     };
+     } mutableCopy];
+    
+    // Log rotation - only saved if overridden
+    PGLogRotationPolicy rotation = self.logRotation;
+    if (rotation.maxSize != PGLogRotationMaxSize) result[PGServerLogMaxSizeKey] = @(rotation.maxSize / (1024 * 1024));
+    if (rotation.maxAge != PGLogRotationMaxAge) result[PGServerLogMaxAgeKey] = @(rotation.maxAge / (60 * 60));
+    if (rotation.maxTotalSize != PGLogRotationMaxTotalSize) result[PGServerLogMaxTotalSizeKey] = @(rotation.maxTotalSize / (1024 * 1024));
+    
+    // Stop - only saved if overridden
+    if (self.shutdown != PGServerShutdownSmart) result[PGServerShutdownKey] = NSStringFromPGServerShutdown(self.shutdown);
+    if (self.checkpointBeforeStop) result[PGServerCheckpointBeforeStopKey] = @YES;
+    if (self.shutdownTimeout != PGServerShutdownTimeout) result[PGServerShutdownTimeoutKey] = @(self.shutdownTimeout);
+    return result;
 }
 - (void)setProperties:(NSDictionary *)properties
 {
@@ -278,6 +303,22 @@ NSString *const PGServerStartupAtLoginName     = @"Login";
     if (properties[PGServerLogFileKey]) self.settings.logFile = ToString(properties[PGServerLogFileKey]);
     if (properties[PGServerPortKey]) self.settings.port = ToString(properties[PGServerPortKey]);
     if (properties[PGServerStartupKey]) self.settings.startup = ToServerStartup(properties[PGServerStartupKey]);
+    
+    // Log rotation
+    PGLogRotationPolicy rotation = self.logRotation;
+    NSNumber *maxSize = ToNumber(properties[PGServerLogMaxSizeKey]);
+    NSNumber *maxAge = ToNumber(properties[PGServerLogMaxAgeKey]);
+    NSNumber *maxTotalSize = ToNumber(properties[PGServerLogMaxTotalSizeKey]);
+    if (maxSize) rotation.maxSize = (unsigned long long)MAX(0, maxSize.doubleValue * 1024 * 1024);
+    if (maxAge) rotation.maxAge = MAX(0, maxAge.doubleValue * 60 * 60);
+    if (maxTotalSize) rotation.maxTotalSize = (unsigned long long)MAX(0, maxTotalSize.doubleValue * 1024 * 1024);
+    self.logRotation = rotation;
+    
+    // Stop
+    if (properties[PGServerShutdownKey]) self.shutdown = ToServerShutdown(properties[PGServerShutdownKey]);
+    if (properties[PGServerCheckpointBeforeStopKey]) self.checkpointBeforeStop = ToBOOL(properties[PGServerCheckpointBeforeStopKey]);
+    NSNumber *shutdownTimeout = ToNumber(properties[PGServerShutdownTimeoutKey]);
+    if (shutdownTimeout) self.shutdownTimeout = MAX(0, shutdownTimeout.doubleValue);
 }
 
 - (BOOL)started
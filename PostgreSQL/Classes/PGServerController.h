@@ -25,7 +25,9 @@
 //
 
 #import <Foundation/Foundation.h>
+#ifdef __APPLE__
 #import <SecurityFoundation/SFAuthorization.h>
+#endif
 #import "PGServer.h"
 #import "PGLaunchd.h"
 #import "PGProcess.h"
@@ -130,6 +132,40 @@ NSStringFromPGServerActionVerb(PGServerAction value)
  */
 - (void)runAction:(PGServerAction)action server:(PGServer *)server auth:(PGAuth *)auth succeeded:(void(^)(void))succeeded failed:(void(^)(NSString *error))failed;
 
+/**
+ * Runs the action on the PostgreSQL server using launchctl, stopping the server with the
+ * specified shutdown mode rather than the server's own, if the action involves a stop.
+ */
+- (void)runAction:(PGServerAction)action server:(PGServer *)server shutdown:(PGServerShutdown)shutdown auth:(PGAuth *)auth succeeded:(void(^)(void))succeeded failed:(void(^)(NSString *error))failed;
+
+/**
+ * Runs the action on all servers concurrently, with at most maxConcurrent running at once.
+ *
+ * The auth is shared, so the user is asked for their password at most once, with a reason
+ * covering all the servers. Only servers that needed rights fail if it is refused. The delegate
+ * is notified of success/failure for each server as it finishes. Once all are finished,
+ * the completed block is called on the main thread with the errors keyed by server uid
+ * (servers that succeeded have no entry) and the total elapsed time.
+ */
+- (void)runAction:(PGServerAction)action servers:(NSArray<PGServer *> *)servers auth:(PGAuth *)auth maxConcurrent:(NSUInteger)maxConcurrent completed:(void(^)(NSDictionary<NSString *, NSString *> *errors, NSTimeInterval duration))completed;
+
+/**
+ * Samples the resources used by the server's processes and adds to its usage history.
+ * Clears the history if the server is not running.
+ *
+ * @return YES if a sample was added
+ */
+- (BOOL)sampleUsageForServer:(PGServer *)server;
+
+/**
+ * Rotates the server's daemon log if it has exceeded the server's log rotation policy.
+ * Old segments are compressed and pruned in the background. Only internal servers' logs
+ * are rotated, and never with authorization - daemonLogUnmanaged is set if the log needs it.
+ *
+ * @return YES if the log was rotated
+ */
+- (BOOL)rotateLogForServer:(PGServer *)server;
+
 /**
  * Lookup up a server running on the system by pid.
  */
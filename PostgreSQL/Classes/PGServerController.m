@@ -25,6 +25,7 @@
 //
 
 #import "PGServerController.h"
+#import "PGLogFile.h"
 
 #pragma mark - Constants / Functions
 
@@ -62,6 +63,40 @@ EqualUsernames(NSString *user1, NSString *user2)
     return [user1 isEqualToString:user2];
 }
 
+/// The signal postgres treats as a request for the shutdown mode
+static inline int
+SignalForShutdown(PGServerShutdown shutdown)
+{
+    switch (shutdown) {
+        case PGServerShutdownFast: return SIGINT;
+        case PGServerShutdownImmediate: return SIGQUIT;
+        default: return SIGTERM;
+    }
+}
+
+/// Reads postmaster.pid in the data directory. YES if it lists the pid as ready for connections.
+/// Assumed ready if the file cannot be read by this user, or is from a version without status.
+/// Asks the process backend instead if one is installed.
+static BOOL
+PostmasterIsReady(NSString *dataDirectory, NSInteger pid)
+{
+    if (!dataDirectory) return YES;
+    
+    id<PGProcessBackend> backend = PGProcess.backend;
+    if (backend) return [backend postmasterIsReadyWithDataDirectory:dataDirectory pid:pid];
+    
+    NSError *error = nil;
+    NSString *contents = [NSString stringWithContentsOfFile:[dataDirectory stringByAppendingPathComponent:@"postmaster.pid"] encoding:NSUTF8StringEncoding error:&error];
+    if (!contents) return error.code == NSFileReadNoPermissionError;
+    
+    // Line 1 is the pid, line 8 the status
+    NSArray<NSString *> *lines = [contents componentsSeparatedByString:@"\n"];
+    if (lines[0].integerValue != pid) return NO;
+    if (lines.count < 8) return YES;
+    NSString *status = TrimToNil(lines[7]);
+    return !status || [status isEqualToString:@"ready"] || [status isEqualToString:@"standby"];
+}
+
 @interface NSDictionary (Filter)
 /// Returns a filtered copy of this dictionary, using the block to decide which keys to include
 - (NSDictionary *)dictionaryByFilteringUsingBlock:(BOOL(^)(id key, id value))block;
@@ -92,8 +127,89 @@ EqualUsernames(NSString *user1, NSString *user2)
 + (instancetype)result:(PGServer *)server;
 @end
 
+/**
+ * Filesystem and user checks needed to validate the settings of one or more servers.
+ *
+ * Servers are added first, then all checks are answered in one pass - with a single
+ * privileged probe for any paths that cannot be checked without authorization. Results
+ * are kept for the life of the plan, i.e. the action or bulk action that created it.
+ */
+@interface PGServerValidationPlan : NSObject
+/// Adds the checks for the server's settings
+- (void)addServer:(PGServer *)server;
+/// Answers all checks not yet answered
+- (void)resolveWithAuth:(PGAuth *)auth;
+/// Marks invalid settings, answering any checks not yet answered. Paths the privileged probe could
+/// not check are not marked invalid - the probe's error is returned instead.
+/// @return NO if any setting is invalid or could not be checked
+- (BOOL)validateServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error;
+@end
+
+/**
+ * An action waiting to be run on a server.
+ *
+ * Check status requests that arrive while another check status is still pending are
+ * merged into it, so their callbacks are collected here rather than run separately.
+ */
+@interface PGServerRequest : NSObject
+@property (nonatomic, readonly) PGServerAction action;
+@property (nonatomic, strong, readonly) PGAuth *auth;
+/// How to stop the server, if the action involves a stop
+@property (nonatomic) PGServerShutdown shutdown;
+/// Checks shared by all servers in a bulk action, or nil if only for this action
+@property (nonatomic, strong) PGServerValidationPlan *validation;
+@property (nonatomic, strong, readonly) NSMutableArray<void(^)(void)> *succeeded;
+@property (nonatomic, strong, readonly) NSMutableArray<void(^)(NSString *)> *failed;
+/// If YES, at least one merged request had no succeeded block, so the delegate must be notified
+@property (nonatomic, readonly) BOOL notifyDelegateOnSuccess;
+/// If YES, at least one merged request had no failed block, so the delegate must be notified
+@property (nonatomic, readonly) BOOL notifyDelegateOnFailure;
+- (instancetype)initWithAction:(PGServerAction)action auth:(PGAuth *)auth succeeded:(void(^)(void))succeeded failed:(void(^)(NSString *error))failed;
+- (void)mergeRequest:(PGServerRequest *)request;
+@end
+
+/**
+ * Serial queue of pending actions for a single server.
+ *
+ * User actions (start/stop etc) jump ahead of pending check status requests,
+ * and at most one check status request is ever pending.
+ */
+@interface PGServerQueue : NSObject
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+- (instancetype)initWithServer:(PGServer *)server;
+/// @return NO if request was merged into an already-pending request
+- (BOOL)enqueue:(PGServerRequest *)request;
+- (PGServerRequest *)dequeue;
+@end
+
 @interface PGServerController ()
 
+/// One action queue per server, released when the server is released
+@property (nonatomic, strong) NSMapTable<PGServer *, PGServerQueue *> *queues;
+
+/// Rotates and compresses daemon logs
+@property (nonatomic, strong) PGLogRotator *logRotator;
+
+/// Daemon settings as loaded by this controller, without Disabled, keyed by domain and label
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *loadedDaemons;
+
+/**
+ * Returns the action queue for the server, creating it if necessary.
+ */
+- (PGServerQueue *)queueForServer:(PGServer *)server;
+
+/**
+ * Runs the action, using the validation plan if not nil, rather than checking the server's settings on its own.
+ */
+- (void)runAction:(PGServerAction)action server:(PGServer *)server shutdown:(PGServerShutdown)shutdown validation:(PGServerValidationPlan *)validation auth:(PGAuth *)auth succeeded:(void(^)(void))succeeded failed:(void(^)(NSString *error))failed;
+
+/**
+ * Checks the server's settings, including that its directories and user exist.
+ *
+ * @param plan checks shared with other servers, or nil to check this server alone
+ */
+- (BOOL)validateSettingsForServer:(PGServer *)server plan:(PGServerValidationPlan *)plan auth:(PGAuth *)auth error:(NSString **)error;
+
 /**
  * Called before running the action. Opportunity to abort action, e.g. if validation fails.
  */
@@ -114,6 +230,36 @@ EqualUsernames(NSString *user1, NSString *user2)
  */
 - (void)didRunAction:(PGServerAction)action server:(PGServer *)server previousResult:(PGServerResult *)previousResult;
 
+/**
+ * @param pid Set to the pid of the loaded job, or 0 if not running
+ * @return YES if the server's daemon is loaded in launchd, in the right context, and was loaded by this
+ *         controller with all the same settings as the server, apart from Disabled
+ */
+- (BOOL)loadedDaemonMatchesServer:(PGServer *)server pid:(NSInteger *)pid;
+
+/**
+ * Blocks until launchd reports a new pid for the daemon and postgres is ready, the new process
+ * exits again, or the timeout expires. If still starting at the timeout, e.g. recovering after
+ * a crash, sets the server's error - status checks show it as starting until it is ready.
+ *
+ * @return YES if the server is ready
+ */
+- (BOOL)waitForDaemonToStartForServer:(PGServer *)server previousPid:(NSInteger)previousPid;
+
+/**
+ * Runs CHECKPOINT on the server using psql, as the server's user, without a password.
+ *
+ * @return YES if the checkpoint succeeded
+ */
+- (BOOL)checkpointServer:(PGServer *)server;
+
+/**
+ * Finds the reason a server failed to start, from the most recent errors in its log.
+ *
+ * @return the error messages, or nil if none found
+ */
+- (NSString *)failureFromLogForServer:(PGServer *)server;
+
 /**
  * Populates all derived properties of server after initial creation.
  */
@@ -172,10 +318,220 @@ EqualUsernames(NSString *user1, NSString *user2)
 
 
 
+#pragma mark - PGServerRequest
+
+@implementation PGServerRequest
+- (instancetype)initWithAction:(PGServerAction)action auth:(PGAuth *)auth succeeded:(void (^)(void))succeeded failed:(void (^)(NSString *))failed
+{
+    self = [super init];
+    if (self) {
+        _action = action;
+        _auth = auth;
+        _succeeded = [NSMutableArray arrayWithCapacity:1];
+        _failed = [NSMutableArray arrayWithCapacity:1];
+        if (succeeded) [_succeeded addObject:[succeeded copy]];
+        else _notifyDelegateOnSuccess = YES;
+        if (failed) [_failed addObject:[failed copy]];
+        else _notifyDelegateOnFailure = YES;
+    }
+    return self;
+}
+- (void)mergeRequest:(PGServerRequest *)request
+{
+    [_succeeded addObjectsFromArray:request.succeeded];
+    [_failed addObjectsFromArray:request.failed];
+    _notifyDelegateOnSuccess = _notifyDelegateOnSuccess || request.notifyDelegateOnSuccess;
+    _notifyDelegateOnFailure = _notifyDelegateOnFailure || request.notifyDelegateOnFailure;
+}
+@end
+
+
+
+#pragma mark - PGServerQueue
+
+@interface PGServerQueue()
+@property (nonatomic, strong) NSMutableArray<PGServerRequest *> *pending;
+@end
+
+@implementation PGServerQueue
+- (instancetype)initWithServer:(PGServer *)server
+{
+    self = [super init];
+    if (self) {
+        NSString *label = [NSString stringWithFormat:@"%@.server.%@", PGPrefsAppID, server.uid];
+        _queue = dispatch_queue_create(label.UTF8String, DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+        _pending = [NSMutableArray array];
+    }
+    return self;
+}
+- (BOOL)enqueue:(PGServerRequest *)request
+{
+    @synchronized(self) {
+        NSUInteger checkStatusIndex = [self.pending indexOfObjectPassingTest:^BOOL(PGServerRequest *pending, NSUInteger idx, BOOL *stop) {
+            return pending.action == PGServerCheckStatus;
+        }];
+
+        // Check status - merge with pending check status
+        if (request.action == PGServerCheckStatus) {
+            if (checkStatusIndex != NSNotFound) {
+                [self.pending[checkStatusIndex] mergeRequest:request];
+                return NO;
+            }
+            [self.pending addObject:request];
+
+        // User action - run before pending check status
+        } else {
+            if (checkStatusIndex != NSNotFound) {
+                [self.pending insertObject:request atIndex:checkStatusIndex];
+            } else {
+                [self.pending addObject:request];
+            }
+        }
+        return YES;
+    }
+}
+- (PGServerRequest *)dequeue
+{
+    @synchronized(self) {
+        PGServerRequest *result = self.pending.firstObject;
+        if (result) [self.pending removeObjectAtIndex:0];
+        return result;
+    }
+}
+@end
+
+
+
+#pragma mark - PGServerValidationPlan
+
+@interface PGServerValidationPlan()
+/// Paths added but not yet checked
+@property (nonatomic, strong) NSMutableSet<NSString *> *pendingPaths;
+/// Usernames added but not yet looked up
+@property (nonatomic, strong) NSMutableSet<NSString *> *pendingUsernames;
+/// Checked paths - PGFileType
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *types;
+/// Error from the last privileged probe, e.g. authorization refused
+@property (nonatomic, strong) NSString *probeError;
+/// Looked-up users - NSNull if not found
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *users;
+@end
+
+@implementation PGServerValidationPlan
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _pendingPaths = [NSMutableSet set];
+        _pendingUsernames = [NSMutableSet set];
+        _types = [NSMutableDictionary dictionary];
+        _users = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+- (void)addServer:(PGServer *)server
+{
+    PGServerSettings *settings = server.settings;
+    NSMutableArray *paths = [NSMutableArray arrayWithCapacity:3];
+    if (NonBlank(settings.binDirectory)) [paths addObject:settings.binDirectory];
+    if (NonBlank(settings.dataDirectory)) [paths addObject:settings.dataDirectory];
+    if (NonBlank(settings.logFile)) [paths addObject:[settings.logFile stringByDeletingLastPathComponent]];
+    
+    @synchronized(self) {
+        for (NSString *path in paths) {
+            if (!self.types[path]) [self.pendingPaths addObject:path];
+        }
+        if (NonBlank(settings.username) && !self.users[settings.username]) [self.pendingUsernames addObject:settings.username];
+    }
+}
+- (void)resolveWithAuth:(PGAuth *)auth
+{
+    @synchronized(self) {
+        for (NSString *username in self.pendingUsernames) {
+            self.users[username] = [PGUser userWithUsername:username] ?: [NSNull null];
+        }
+        [self.pendingUsernames removeAllObjects];
+        
+        if (self.pendingPaths.count == 0) return;
+        
+        // Single pass - paths are unknown if authorization fails
+        NSString *error = nil;
+        [self.types addEntriesFromDictionary:[PGFile typesOfFilesAtPaths:self.pendingPaths.allObjects auth:auth error:&error]];
+        if (error) DLog(@"%@", error);
+        self.probeError = error;
+        [self.pendingPaths removeAllObjects];
+    }
+}
+- (BOOL)validateServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString *__autoreleasing *)error
+{
+    [self addServer:server];
+    [self resolveWithAuth:auth];
+    
+    PGServerSettings *settings = server.settings;
+    NSString *logDirectory = NonBlank(settings.logFile) ? [settings.logFile stringByDeletingLastPathComponent] : nil;
+    BOOL unknown = NO;
+    NSString *probeError = nil;
+    @synchronized(self) {
+        // Username
+        if (NonBlank(settings.username) && self.users[settings.username] == [NSNull null]) {
+            settings.invalidUsername = @"No such user";
+        }
+        
+        // Bin directory
+        PGFileType type = self.types[settings.binDirectory].integerValue;
+        if (type == PGFileUnknown) unknown = YES;
+        else if (type != PGFileDir) settings.invalidBinDirectory = @"No such directory";
+        
+        // Data directory
+        type = self.types[settings.dataDirectory].integerValue;
+        if (type == PGFileUnknown) unknown = YES;
+        else if (type != PGFileDir) settings.invalidDataDirectory = @"No such directory";
+        
+        // Log directory
+        if (logDirectory) {
+            type = self.types[logDirectory].integerValue;
+            if (type == PGFileUnknown) unknown = YES;
+            else if (type != PGFileDir) settings.invalidLogFile = @"No such directory";
+        }
+        probeError = self.probeError;
+    }
+    
+    if (!settings.valid) {
+        if (error) *error = @"Server settings are invalid";
+        return NO;
+    }
+    
+    // Not checked - e.g. password prompt cancelled, so the settings may well be valid
+    if (unknown) {
+        // A bulk probe ran on the shared auth, so record the outcome for this server's auth too
+        if (auth) [auth authorize:PGProcess.rights];
+        if (error) *error = probeError ?: @"Cannot check server directories";
+        return NO;
+    }
+    return YES;
+}
+@end
+
+
+
 #pragma mark - PGServerController
 
 @implementation PGServerController
 
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        self.queues = [NSMapTable weakToStrongObjectsMapTable];
+        self.logRotator = [[PGLogRotator alloc] init];
+        self.loadedDaemons = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+
+
 #pragma mark Properties
 
 - (PGRights *)rights
@@ -199,179 +555,256 @@ EqualUsernames(NSString *user1, NSString *user2)
 
 - (void)runAction:(PGServerAction)action server:(PGServer *)server auth:(PGAuth *)auth succeeded:(void (^)(void))succeeded failed:(void (^)(NSString *error))failed
 {
-    BackgroundThread(^{
-        [self runActionAndWait:action server:server auth:auth succeeded:succeeded failed:failed];
-    });
+    [self runAction:action server:server shutdown:server.shutdown auth:auth succeeded:succeeded failed:failed];
+}
+
+- (void)runAction:(PGServerAction)action server:(PGServer *)server shutdown:(PGServerShutdown)shutdown auth:(PGAuth *)auth succeeded:(void (^)(void))succeeded failed:(void (^)(NSString *error))failed
+{
+    [self runAction:action server:server shutdown:shutdown validation:nil auth:auth succeeded:succeeded failed:failed];
 }
 
-- (void)runActionAndWait:(PGServerAction)action server:(PGServer *)server auth:(PGAuth *)auth succeeded:(void (^)(void))succeeded failed:(void (^)(NSString *error))failed
+- (void)runAction:(PGServerAction)action server:(PGServer *)server shutdown:(PGServerShutdown)shutdown validation:(PGServerValidationPlan *)validation auth:(PGAuth *)auth succeeded:(void (^)(void))succeeded failed:(void (^)(NSString *error))failed
 {
     // Abort quickly
     if (!server) return;
-    if (server.processing && action == PGServerCheckStatus) return;
+    
+    PGServerRequest *request = [[PGServerRequest alloc] initWithAction:action auth:auth succeeded:succeeded failed:failed];
+    request.shutdown = shutdown;
+    request.validation = validation;
+    PGServerQueue *queue = [self queueForServer:server];
+    
+    // Merged into pending check status
+    if (![queue enqueue:request]) return;
     
     // One action at a time for a server.
-    // Note: thread blocks holding synchronized lock until done
-    @synchronized(server) {
+    // Note: the next pending request is dequeued when the block runs, so that
+    // user actions overtake any check status requests already waiting.
+    dispatch_async(queue.queue, ^{
+        PGServerRequest *next = [queue dequeue];
+        if (next) [self runRequestAndWait:next server:server];
+    });
+}
+
+- (void)runAction:(PGServerAction)action servers:(NSArray<PGServer *> *)servers auth:(PGAuth *)auth maxConcurrent:(NSUInteger)maxConcurrent completed:(void (^)(NSDictionary<NSString *,NSString *> *, NSTimeInterval))completed
+{
+    servers = [servers copy];
+    NSTimeInterval startTime = [PGProcess now];
     
-        NSString *error = nil;
-        
-        // Cache the existing status, because may need to revert to it if errors
-        PGServerResult *previousResult = [PGServerResult result:server];
-            
-        // Validate server settings
-        if ([self shouldRunAction:action server:server previousResult:previousResult error:&error]) {
+    // Errors are only accessed on main thread
+    NSMutableDictionary<NSString *, NSString *> *errors = [NSMutableDictionary dictionaryWithCapacity:servers.count];
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(maxConcurrent, 1));
+    
+    // One prompt for all servers - each server doesn't overwrite the reason
+    if (!auth.reason && servers.count > 0) {
+        auth.reason = @{PGAuthReasonAction:NSStringFromPGServerActionVerb(action), PGAuthReasonTarget:(servers.count == 1 ? servers.firstObject.name : [NSString stringWithFormat:@"%@ servers", @(servers.count)])};
+    }
+    
+    BackgroundThread(^{
         
-            // For some actions, don't show a spinning wheel,
-            // and don't remove the existing error until finished
-            if (action != PGServerCheckStatus) {
-                server.error = nil;
-                server.errorDomain = action;
-            }
-            if (! (action == PGServerCheckStatus ||
-                   action == PGServerCreate) ) {
-                server.processing = YES;
-            }
-
-            // Notify delegate
-            MainThread(^{
-                [self.delegate server:server willRunAction:action];
-            });
-            
-            // Execute
-            switch (action) {
-                    
-                case PGServerCheckStatus:
-                    [self checkStatusForServer:server];
-                    break;
-                    
-                case PGServerStop:
-                    [self stopServer:server all:!server.external auth:auth error:&error];
-                    break;
-                    
-                case PGServerStart:
-                    // Internal server
-                    if (!server.external) {
-                        // Validate
-                        if (![self validateSettingsForServer:server auth:auth error:&error]) break;
-                        // Unload
-                        if (![self stopServer:server all:YES auth:auth error:&error]) break;
-                        // Delete
-                        if (![self deleteDaemonFileForServer:server all:YES auth:auth error:&error]) break;
-                        // Create Daemon
-                        if (![self createDaemonFileForServer:server auth:auth error:&error]) break;
-                        // Create Log File
-                        if (![self createLogFileForServer:server auth:auth error:&error]) break;
-                        // Load
-                        [self loadDaemonForServer:server auth:auth error:&error];
-                        
-                    // External server
-                    } else {
-                        // Unload
-                        if (![self stopServer:server all:NO auth:auth error:&error]) break;
-                        // Load
-                        [self loadDaemonForServer:server auth:auth error:&error];
-                    }
-                    break;
-                    
-                case PGServerDelete:
-                    if (![self stopServer:server all:!server.external auth:auth error:&error]) break;
-                    [self deleteDaemonFileForServer:server all:!server.external auth:auth error:&error];
-                    break;
-                    
-                case PGServerCreate:
-                    if (server.external) {
-                        error = @"Program error - cannot create external server";
-                        break;
-                    }
-                    if (![self deleteDaemonFileForServer:server all:YES auth:auth error:&error]) break;
-                    [self createDaemonFileForServer:server auth:auth error:&error];
-                    break;
-            }
-            
-            // Don't change spinning wheel for some actions
-            if (! (action == PGServerCheckStatus ||
-                   action == PGServerCreate)) {
-                server.processing = NO;
+        // Starting - check all servers' settings together, so at most one privileged probe
+        PGServerValidationPlan *validation = nil;
+        if (action == PGServerStart) {
+            validation = [[PGServerValidationPlan alloc] init];
+            for (PGServer *server in servers) {
+                if (!server.external) [validation addServer:server];
             }
+            [validation resolveWithAuth:auth];
         }
         
-        // Auth error
-        if (auth.requested &&
-            auth.status != errAuthorizationSuccess) {
-            if (!error) { error = [NSString stringWithFormat:@"Authorization required to %@", NSStringFromPGServerAction(action).lowercaseString]; }
-            [self didFailAuthForAction:action server:server previousResult:previousResult auth:auth error:error];
-         
-        // Error
-        } else if (error) {
-            [self didFailAction:action server:server previousResult:previousResult error:error];
+        for (PGServer *server in servers) {
             
-        // Check result
-        } else {
-            [self didRunAction:action server:server previousResult:previousResult];
+            // Wait for a free slot
+            dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+            dispatch_group_enter(group);
+            
+            // Own auth per server, so a refused prompt only fails servers that needed rights
+            PGAuth *serverAuth = auth ? [[PGAuth alloc] initWithParent:auth] : nil;
+            [self runAction:action server:server shutdown:server.shutdown validation:validation auth:serverAuth succeeded:^{
+                [self.delegate server:server didSucceedAction:action];
+                dispatch_semaphore_signal(slots);
+                dispatch_group_leave(group);
+            } failed:^(NSString *error) {
+                errors[server.uid] = error;
+                [self.delegate server:server didFailAction:action error:error];
+                dispatch_semaphore_signal(slots);
+                dispatch_group_leave(group);
+            }];
         }
         
-        // Log
-        if (IsLogging) {
-            DLog(@"[%@] %@ : %@%@", server.name, NSStringFromPGServerAction(action), NSStringFromPGServerStatus(server.status), (server.error?[NSString stringWithFormat:@"\n\n[error] %@", server.error]:@""));
-        }
-
-        // Notify delegate - keep notifications ordered correctly
-        // by scheduling on main while still holding synchronized lock.
-        MainThreadAfterDelay(0, ^{
-            if (NonBlank(error)) {
-                if (failed) failed(error);
-                else [self.delegate server:server didFailAction:action error:error];
-            } else {
-                if (succeeded) succeeded();
-                else [self.delegate server:server didSucceedAction:action];
-            }
-            [self.delegate server:server didRunAction:action];
+        // All finished
+        dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+            NSTimeInterval duration = [PGProcess now] - startTime;
+            DLog(@"%@ %@ servers: %@ failed, %.2fs", NSStringFromPGServerAction(action), @(servers.count), @(errors.count), duration);
+            if (completed) completed(errors, duration);
         });
-        
-    } // End synchronized
+    });
 }
 
-- (BOOL)validateSettingsForServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error
+- (PGServerQueue *)queueForServer:(PGServer *)server
 {
-    PGServerSettings *settings = server.settings;
-    [self validateServerSettings:settings];
-    if (!settings.valid) {
-        if (error) *error = @"Server settings are invalid";
-        return NO;
+    @synchronized(self.queues) {
+        PGServerQueue *result = [self.queues objectForKey:server];
+        if (!result) {
+            result = [[PGServerQueue alloc] initWithServer:server];
+            [self.queues setObject:result forKey:server];
+        }
+        return result;
     }
+}
+
+- (void)runRequestAndWait:(PGServerRequest *)request server:(PGServer *)server
+{
+    PGServerAction action = request.action;
+    PGAuth *auth = request.auth;
+    PGServerValidationPlan *validation = request.validation ?: [[PGServerValidationPlan alloc] init];
+    NSString *error = nil;
     
-    PGUser *user = [PGUser userWithUsername:settings.username];
-    
-    // Username
-    if (NonBlank(settings.username) && !user) {
-        settings.invalidUsername = @"No such user";
-    }
+    // Cache the existing status, because may need to revert to it if errors
+    PGServerResult *previousResult = [PGServerResult result:server];
+        
+    // Validate server settings
+    if ([self shouldRunAction:action server:server previousResult:previousResult error:&error]) {
     
-    // Bin directory
-    if (![PGFile dirExists:settings.binDirectory user:user auth:auth error:error]) {
-        settings.invalidBinDirectory = @"No such directory";
-    }
+        // For some actions, don't show a spinning wheel,
+        // and don't remove the existing error until finished
+        if (action != PGServerCheckStatus) {
+            server.error = nil;
+            server.errorDomain = action;
+            server.waitTime = 0;
+        }
+        if (! (action == PGServerCheckStatus ||
+               action == PGServerCreate) ) {
+            server.processing = YES;
+        }
 
-    
-    // Data directory
-    if (![PGFile dirExists:settings.dataDirectory user:user auth:auth error:error]) {
-        settings.invalidDataDirectory = @"No such directory";
+        // Notify delegate
+        MainThread(^{
+            [self.delegate server:server willRunAction:action];
+        });
+        
+        // Execute
+        switch (action) {
+                
+            case PGServerCheckStatus:
+                [self checkStatusForServer:server];
+                break;
+                
+            case PGServerStop:
+                [self stopServer:server all:!server.external shutdown:request.shutdown auth:auth error:&error];
+                break;
+                
+            case PGServerStart: {
+                // Internal server - already loaded by this controller with the same settings, and not
+                // running. If running, it is stopped with the server's shutdown mode then reloaded below.
+                NSInteger loadedPid = 0;
+                if (!server.external && [self loadedDaemonMatchesServer:server pid:&loadedPid] && loadedPid == 0) {
+                    // Validate
+                    if (![self validateSettingsForServer:server plan:validation auth:auth error:&error]) break;
+                    // Delete from other locations
+                    if (![self deleteOtherDaemonFilesForServer:server auth:auth error:&error]) break;
+                    // Create Daemon - only written if changed, e.g. startup
+                    if (![self createDaemonFileForServer:server auth:auth error:&error]) break;
+                    // Create Log File
+                    if (!server.daemonLogExists && ![self createLogFileForServer:server auth:auth error:&error]) break;
+                    // Start
+                    [self restartDaemonForServer:server auth:auth error:&error];
+                    
+                // Internal server
+                } else if (!server.external) {
+                    // Validate
+                    if (![self validateSettingsForServer:server plan:validation auth:auth error:&error]) break;
+                    // Unload
+                    if (![self stopServer:server all:YES shutdown:request.shutdown auth:auth error:&error]) break;
+                    // Delete from other locations - current file is only rewritten if changed
+                    if (![self deleteOtherDaemonFilesForServer:server auth:auth error:&error]) break;
+                    // Create Daemon
+                    if (![self createDaemonFileForServer:server auth:auth error:&error]) break;
+                    // Create Log File
+                    if (![self createLogFileForServer:server auth:auth error:&error]) break;
+                    // Load
+                    [self loadDaemonForServer:server auth:auth error:&error];
+                    
+                // External server
+                } else {
+                    // Unload
+                    if (![self stopServer:server all:NO shutdown:request.shutdown auth:auth error:&error]) break;
+                    // Load
+                    [self loadDaemonForServer:server auth:auth error:&error];
+                }
+                break;
+            }
+                
+            case PGServerDelete:
+                if (![self stopServer:server all:!server.external shutdown:request.shutdown auth:auth error:&error]) break;
+                [self deleteDaemonFileForServer:server all:!server.external auth:auth error:&error];
+                break;
+                
+            case PGServerCreate:
+                if (server.external) {
+                    error = @"Program error - cannot create external server";
+                    break;
+                }
+                if (![self deleteOtherDaemonFilesForServer:server auth:auth error:&error]) break;
+                [self createDaemonFileForServer:server auth:auth error:&error];
+                break;
+        }
+        
+        // Don't change spinning wheel for some actions
+        if (! (action == PGServerCheckStatus ||
+               action == PGServerCreate)) {
+            server.processing = NO;
+        }
     }
     
-    // Log directory
-    if (NonBlank(settings.logFile) && ![PGFile dirExists:[settings.logFile stringByDeletingLastPathComponent] user:user auth:auth error:error]) {
-        settings.invalidLogFile = @"No such directory";
+    // Auth error
+    if (auth.requested &&
+        auth.status != errAuthorizationSuccess) {
+        if (!error) { error = [NSString stringWithFormat:@"Authorization required to %@", NSStringFromPGServerAction(action).lowercaseString]; }
+        [self didFailAuthForAction:action server:server previousResult:previousResult auth:auth error:error];
+     
+    // Error
+    } else if (error) {
+        [self didFailAction:action server:server previousResult:previousResult error:error];
+        
+    // Check result
+    } else {
+        [self didRunAction:action server:server previousResult:previousResult];
     }
     
+    // Log
+    if (IsLogging) {
+        DLog(@"[%@] %@ : %@ (waited %.3fs)%@", server.name, NSStringFromPGServerAction(action), NSStringFromPGServerStatus(server.status), server.waitTime, (server.error?[NSString stringWithFormat:@"\n\n[error] %@", server.error]:@""));
+    }
+
+    // Notify delegate - keep notifications ordered correctly
+    // by scheduling on main while still on the server's queue.
+    MainThreadAfterDelay(0, ^{
+        if (NonBlank(error)) {
+            for (void(^failed)(NSString *) in request.failed) failed(error);
+            if (request.notifyDelegateOnFailure) [self.delegate server:server didFailAction:action error:error];
+        } else {
+            for (void(^succeeded)(void) in request.succeeded) succeeded();
+            if (request.notifyDelegateOnSuccess) [self.delegate server:server didSucceedAction:action];
+        }
+        [self.delegate server:server didRunAction:action];
+    });
+}
+
+- (BOOL)validateSettingsForServer:(PGServer *)server plan:(PGServerValidationPlan *)plan auth:(PGAuth *)auth error:(NSString **)error
+{
+    PGServerSettings *settings = server.settings;
+    [self validateServerSettings:settings];
     if (!settings.valid) {
         if (error) *error = @"Server settings are invalid";
         return NO;
     }
-    return YES;
+    
+    // Filesystem and user checks - answered together, and only once per plan
+    return [plan ?: [[PGServerValidationPlan alloc] init] validateServer:server auth:auth error:error];
 }
 
-- (BOOL)stopServer:(PGServer *)server all:(BOOL)all auth:(PGAuth *)auth error:(NSString **)outerr
+- (BOOL)stopServer:(PGServer *)server all:(BOOL)all shutdown:(PGServerShutdown)shutdown auth:(PGAuth *)auth error:(NSString **)outerr
 {
     // 'launchctl bootout' on Catalina returns an error message,
     // even though it succeeds. So error is not always reliable.
@@ -380,25 +813,69 @@ EqualUsernames(NSString *user1, NSString *user2)
     if (outerr) { *outerr = nil; }
     NSString *error = nil;
     
+    NSInteger pid = server.pid;
+    PGProcess *process = pid ? [PGProcess runningProcessWithPid:pid] : nil;
+    BOOL root = process.user.isOtherUser;
+    NSMutableDictionary *phases = [NSMutableDictionary dictionaryWithCapacity:4];
+    NSTimeInterval start = [PGProcess now];
+    
+    // Checkpoint - failure is not an error, it only makes the next start slower
+    if (process && server.checkpointBeforeStop) {
+        [self checkpointServer:server];
+        phases[@"Checkpoint"] = @([PGProcess now] - start);
+        start = [PGProcess now];
+    }
+    
+    // Fast/Immediate - signal before unloading, which would begin a smart shutdown
+    if (process && shutdown != PGServerShutdownSmart) {
+        [PGProcess signal:SignalForShutdown(shutdown) pid:pid forRootUser:root auth:auth error:&error];
+    }
+    
     // Unload using launchctl
     [self unloadDaemonForServer:server all:all auth:auth error:&error];
-    [NSThread sleepForTimeInterval:1.0];
     
-    if (!server.pid) return YES;
+    // No pid - wait for launchd to remove the job
+    if (!pid) {
+        WaitUntil(server.shutdownTimeout, ^BOOL{
+            return ![PGLaunchd loadedDaemonWithName:server.daemonName forRootUser:server.daemonFileOwner.isRootUser];
+        });
+        server.waitTime += [PGProcess now] - start;
+        return YES;
+    }
     
-    // Check stopped
-    PGProcess *process = [PGProcess runningProcessWithPid:server.pid];
-    if (!process) return YES;
+    // Wait for exit, escalating to the next mode at each deadline
+    BOOL stopped = NO;
+    for (PGServerShutdown mode = shutdown; ; mode++) {
+        stopped = [PGProcess waitForPid:pid toExitWithTimeout:(mode == PGServerShutdownImmediate ? PGServerImmediateShutdownTimeout : server.shutdownTimeout)];
+        phases[NSStringFromPGServerShutdown(mode)] = @([PGProcess now] - start);
+        if (stopped || mode == PGServerShutdownImmediate) break;
+        
+        start = [PGProcess now];
+        [PGProcess signal:SignalForShutdown(mode + 1) pid:pid forRootUser:root auth:auth error:&error];
+    }
+    
+    server.stopPhaseTimes = phases;
+    for (NSNumber *time in phases.allValues) server.waitTime += time.doubleValue;
+    DLog(@"[%@] Stop phases: %@", server.name, phases);
     
-    // Still running - kill
-    [PGProcess kill:server.pid forRootUser:process.user.isOtherUser auth:auth error:&error];
-
     // Check stopped
-    process = [PGProcess runningProcessWithPid:server.pid];
-    if (!process) return YES;
+    if (stopped || ![PGProcess runningProcessWithPid:pid]) return YES;
     
     // Still running - error
-    if (outerr) { *outerr = error; }
+    if (outerr) { *outerr = error ?: @"Server did not stop after immediate shutdown"; }
+    return NO;
+}
+- (BOOL)checkpointServer:(PGServer *)server
+{
+    NSString *psql = [[server.settings.binDirectory stringByExpandingTildeInPath] stringByAppendingPathComponent:@"psql"];
+    NSString *connection = [NSString stringWithFormat:@"dbname=postgres user=%@ port=%@ connect_timeout=2 options='-c statement_timeout=%d'", server.settings.username ?: NSUserName(), server.settings.port ?: @"5432", PGServerCheckpointTimeout * 1000];
+    
+    // Output is the command tag if succeeded, otherwise the error
+    NSString *error = nil;
+    NSString *output = [PGProcess runExecutable:psql withArgs:@[@"-X", @"-w", @"-d", connection, @"-c", @"CHECKPOINT"] error:&error];
+    if ([output isEqualToString:@"CHECKPOINT"]) return YES;
+    
+    DLog(@"[%@] Checkpoint failed: %@", server.name, error ?: output);
     return NO;
 }
 - (BOOL)unloadDaemonForServer:(PGServer *)server all:(BOOL)all auth:(PGAuth *)auth error:(NSString **)error
@@ -410,12 +887,14 @@ EqualUsernames(NSString *user1, NSString *user2)
     };
 
     if (![PGLaunchd stopDaemonWithName:server.daemonName forRootUser:server.daemonFileOwner.isRootUser auth:auth error:error]) return NO;
+    [self setLoadedDaemon:nil forServer:server root:server.daemonFileOwner.isRootUser];
     
     if (!all) return YES;
     
     if ([PGLaunchd loadedDaemonWithName:server.daemonName forRootUser:!server.daemonFileOwner.isRootUser]) {
         if (![PGLaunchd stopDaemonWithName:server.daemonName forRootUser:!server.daemonFileOwner.isRootUser auth:auth error:error]) return NO;
     }
+    [self setLoadedDaemon:nil forServer:server root:!server.daemonFileOwner.isRootUser];
     
     return YES;
 }
@@ -423,25 +902,119 @@ EqualUsernames(NSString *user1, NSString *user2)
 {
     __block BOOL result = NO;
     __block NSString *error = nil;
-    [PGFile temporaryFileWithExtension:@".plist" usingBlock:^(NSString *tempPath) {
+    BOOL root = server.daemonFileOwner.isRootUser;
+    
+    // For authInfo popup
+    auth.reason = @{
+        PGAuthReasonAction: @"Start PostgreSQL using",
+        PGAuthReasonTarget: @"system launchd"
+    };
+    
+    // Daemon file is current and enabled, e.g. starts at boot - load it as is
+    NSDictionary *daemon = [NSDictionary dictionaryWithContentsOfFile:[server.daemonFile stringByExpandingTildeInPath]];
+    if (daemon && !ToBOOL(daemon[@"Disabled"])) {
+        result = [PGLaunchd startDaemonWithFile:server.daemonFile forRootUser:root auth:auth error:&error];
         
-        // Create temp plist file with "Disabled" property set to false
-        result = [self createEnabledDaemonFileForServer:server path:tempPath auth:auth error:&error];
-        if (!result) { return; }
-
-        // For authInfo popup
-        auth.reason = @{
-            PGAuthReasonAction: @"Start PostgreSQL using",
-            PGAuthReasonTarget: @"system launchd"
-        };
-
-        // Load
-        result = [PGLaunchd startDaemonWithFile:tempPath forRootUser:server.daemonFileOwner.isRootUser auth:auth error:&error];
-    }];
+    // Disabled - load a copy with "Disabled" removed, written without privileges.
+    // Launchd takes ownership of it as part of the load.
+    } else {
+        [PGFile temporaryFileWithExtension:@".plist" usingBlock:^(NSString *tempPath) {
+            result = [self createEnabledDaemonFileForServer:server path:tempPath error:&error];
+            if (!result) { return; }
+            result = [PGLaunchd startDaemonWithFile:tempPath forRootUser:root auth:auth error:&error];
+        }];
+    }
     if (outerr) { *outerr = error; }
-    if (result) { [NSThread sleepForTimeInterval:1.0]; }
+    if (result) {
+        [self setLoadedDaemon:[self enabledDaemonFromServer:server] forServer:server root:root];
+        [self waitForDaemonToStartForServer:server previousPid:0];
+    }
+    return result;
+}
+- (void)setLoadedDaemon:(NSDictionary *)daemon forServer:(PGServer *)server root:(BOOL)root
+{
+    if (!server.daemonName) return;
+    NSString *key = [NSString stringWithFormat:@"%@/%@", @(root), server.daemonName];
+    @synchronized(self.loadedDaemons) {
+        if (daemon) self.loadedDaemons[key] = daemon;
+        else [self.loadedDaemons removeObjectForKey:key];
+    }
+}
+- (BOOL)loadedDaemonMatchesServer:(PGServer *)server pid:(NSInteger *)pid
+{
+    // Must be loaded in the expected context only
+    BOOL root = server.daemonFileOwner.isRootUser;
+    NSDictionary *loaded = [PGLaunchd loadedDaemonWithName:server.daemonName forRootUser:root];
+    if (pid) *pid = MAX(ToString(loaded[@"PID"]).integerValue, 0);
+    if (!loaded) return NO;
+    if ([PGLaunchd loadedDaemonWithName:server.daemonName forRootUser:!root]) return NO;
+    
+    // Compare the settings launchd reports for a loaded job
+    NSDictionary *daemon = [self daemonFromServer:server];
+    if (![daemon[@"ProgramArguments"] isEqual:loaded[@"ProgramArguments"]]) return NO;
+    for (NSString *key in @[@"StandardOutPath", @"StandardErrorPath"]) {
+        if (!BothNilOrEqual(daemon[key], loaded[key])) return NO;
+    }
+    
+    // Not always reported
+    if (loaded[@"UserName"] && !BothNilOrEqual(daemon[@"UserName"], loaded[@"UserName"])) return NO;
+    
+    // Launchd doesn't report every setting, e.g. RunAtLoad, so compare all with what was loaded.
+    // Jobs loaded before this controller existed are reloaded once.
+    NSDictionary *recorded = nil;
+    @synchronized(self.loadedDaemons) {
+        recorded = self.loadedDaemons[[NSString stringWithFormat:@"%@/%@", @(root), server.daemonName]];
+    }
+    return [recorded isEqualToDictionary:[self enabledDaemonFromServer:server]];
+}
+- (BOOL)restartDaemonForServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error
+{
+    // For authInfo popup
+    auth.reason = @{
+        PGAuthReasonAction: @"Start PostgreSQL using",
+        PGAuthReasonTarget: @"system launchd"
+    };
+    
+    NSInteger previousPid = server.pid;
+    BOOL result = [PGLaunchd restartDaemonWithName:server.daemonName forRootUser:server.daemonFileOwner.isRootUser auth:auth error:error];
+    if (result) { [self waitForDaemonToStartForServer:server previousPid:previousPid]; }
     return result;
 }
+- (BOOL)waitForDaemonToStartForServer:(PGServer *)server previousPid:(NSInteger)previousPid
+{
+    NSTimeInterval start = [PGProcess now];
+    BOOL root = server.daemonFileOwner.isRootUser;
+    NSString *dataDirectory = [server.settings.dataDirectory stringByExpandingTildeInPath];
+    
+    // Launchd reports a new pid, and postgres reports it is ready
+    __block NSInteger startedPid = 0;
+    __block BOOL exited = NO;
+    BOOL started = WaitUntil(PGServerStartTimeout, ^BOOL{
+        NSDictionary *loaded = [PGLaunchd loadedDaemonWithName:server.daemonName forRootUser:root];
+        NSInteger pid = ToString(loaded[@"PID"]).integerValue;
+        
+        // Exited again, e.g. invalid config - launchd retries, and the status check reports why
+        if (startedPid > 0 && pid != startedPid) {
+            exited = YES;
+            return YES;
+        }
+        
+        if (pid <= 0 || pid == previousPid) return NO;
+        startedPid = pid;
+        return PostmasterIsReady(dataDirectory, pid);
+    });
+    if (exited) started = NO;
+    
+    // Still starting - not an error yet, but don't report it as ready
+    if (!started && !exited) {
+        server.error = [NSString stringWithFormat:@"Not ready after %.0f seconds - still starting, e.g. recovering after a crash", PGServerStartTimeout];
+        server.errorDomain = PGServerStart;
+    }
+    
+    server.waitTime += [PGProcess now] - start;
+    DLog(@"[%@] %@ after %.3fs", server.name, started ? @"Ready" : (exited ? @"Exited" : @"Not ready"), [PGProcess now] - start);
+    return started;
+}
 - (BOOL)deleteDaemonFileForServer:(PGServer *)server all:(BOOL)all auth:(PGAuth *)auth error:(NSString **)error
 {
     // For authInfo popup
@@ -471,6 +1044,23 @@ EqualUsernames(NSString *user1, NSString *user2)
 
     return YES;
 }
+- (BOOL)deleteOtherDaemonFilesForServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error
+{
+    // For authInfo popup
+    NSMutableDictionary *reason = [NSMutableDictionary dictionary];
+    auth.reason = reason;
+    reason[PGAuthReasonAction] = @"Remove the PostgreSQL launch file from";
+    
+    NSString *daemonFile = [server.daemonFile stringByExpandingTildeInPath];
+    for (NSString *file in @[server.daemonFileForAllUsersAtBoot, server.daemonFileForAllUsersAtLogin, server.daemonFileForCurrentUserOnly]) {
+        if ([[file stringByExpandingTildeInPath] isEqualToString:daemonFile]) continue;
+        if (![PGFile fileExists:file]) continue;
+        
+        reason[PGAuthReasonTarget] = [file stringByDeletingLastPathComponent];
+        if (![PGFile remove:file auth:auth error:error]) return NO;
+    }
+    return YES;
+}
 - (BOOL)createDaemonFileForServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error
 {
     // For authInfo popup
@@ -484,23 +1074,25 @@ EqualUsernames(NSString *user1, NSString *user2)
     
     return [PGFile createPlistFile:server.daemonFile contents:daemon user:server.daemonFileOwner auth:auth error:error];
 }
-- (BOOL)createEnabledDaemonFileForServer:(PGServer *)server path:(NSString *)path auth:(PGAuth *)auth error:(NSString **)error
+- (NSDictionary *)enabledDaemonFromServer:(PGServer *)server
 {
-    // For authInfo popup
-    auth.reason = @{
-        PGAuthReasonAction: @"Create the PostgreSQL launch file for",
-        PGAuthReasonTarget: @"system launchd"
-    };
-
-    NSDictionary *daemon = [self daemonFromServer:server];
-    if (daemon.count == 0) return NO;
-    
     // Remove disabled setting
-    daemon = [daemon dictionaryByFilteringUsingBlock:^BOOL(id key, id value) {
+    return [[self daemonFromServer:server] dictionaryByFilteringUsingBlock:^BOOL(id key, id value) {
         return ![key isEqualToString:@"Disabled"];
     }];
+}
+- (BOOL)createEnabledDaemonFileForServer:(PGServer *)server path:(NSString *)path error:(NSString **)error
+{
+    NSDictionary *daemon = [self enabledDaemonFromServer:server];
+    if (daemon.count == 0) return NO;
     
-    return [PGFile createPlistFile:path contents:daemon user:server.daemonFileOwner auth:auth error:error];
+    // Temporary - written directly, and not recorded as a known daemon file
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:daemon format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    if (data.length == 0 || ![data writeToFile:path atomically:NO]) {
+        if (error) *error = [NSString stringWithFormat:@"Error creating property file: %@", path];
+        return NO;
+    }
+    return YES;
 }
 - (BOOL)createLogFileForServer:(PGServer *)server auth:(PGAuth *)auth error:(NSString **)error
 {
@@ -519,6 +1111,33 @@ EqualUsernames(NSString *user1, NSString *user2)
     return YES;
 }
 
+- (BOOL)sampleUsageForServer:(PGServer *)server
+{
+    if (!server) return NO;
+    
+    PGProcessUsage usage;
+    if (server.status != PGServerStarted || server.pid <= 0 ||
+        ![PGProcess sampleUsage:&usage forPid:server.pid]) {
+        [server.usageHistory removeAllUsage];
+        return NO;
+    }
+    
+    [server.usageHistory addUsage:usage];
+    return YES;
+}
+
+- (BOOL)rotateLogForServer:(PGServer *)server
+{
+    // External servers' logs belong to other software
+    if (!server || server.external) return NO;
+    
+    NSString *error = nil;
+    BOOL result = [self.logRotator rotateLog:server.daemonLog policy:server.logRotation error:&error];
+    if (error) DLog(@"%@: %@", server.name, error);
+    server.daemonLogUnmanaged = ![self.logRotator canRotateLog:server.daemonLog];
+    return result;
+}
+
 - (PGServer *)runningServerWithPid:(NSInteger)pid
 {
     return [self serverFromProcess:[PGProcess runningProcessWithPid:pid]];
@@ -986,6 +1605,11 @@ EqualUsernames(NSString *user1, NSString *user2)
         server.status = loaded.status;
         server.daemonLoadedForAllUsers = loaded.daemonLoadedForAllUsers;
         
+        // Running, but not yet accepting connections, e.g. recovering after a crash
+        if (server.status == PGServerStarted && server.pid > 0 && !PostmasterIsReady([server.settings.dataDirectory stringByExpandingTildeInPath], server.pid)) {
+            server.status = PGServerStarting;
+        }
+        
         // Validate Bin Directory
         if (NonBlank(loaded.settings.binDirectory) && !EqualPaths(loaded.settings.binDirectory, server.settings.binDirectory)) {
             server.error = @"Running with different bin directory!";
@@ -1005,10 +1629,22 @@ EqualUsernames(NSString *user1, NSString *user2)
         // No problems
         } else {
             if (server.status != prevStatus) server.error = nil;
+            
+            // Just failed to start - launchd is retrying, so the reason is in the log
+            if (server.status == PGServerRetrying && prevStatus != PGServerRetrying) {
+                server.error = [self failureFromLogForServer:server];
+                if (server.error) server.errorDomain = PGServerStart;
+            }
         }
     }
 }
 
+- (NSString *)failureFromLogForServer:(PGServer *)server
+{
+    NSArray<NSString *> *messages = [PGLogFile lastMessagesInFile:server.daemonLog severity:PGLogSeverityError maxCount:PGServerFailureMaxMessages maxBytes:PGServerFailureMaxLogBytes];
+    return messages.count > 0 ? [messages componentsJoinedByString:@"\n"] : nil;
+}
+
 - (NSArray<NSString *> *)programArgsFromCommand:(NSString *)command
 {
     NSArray<NSString *> *args = [command componentsSeparatedByString:@" "];
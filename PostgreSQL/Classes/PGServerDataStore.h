@@ -33,12 +33,21 @@
 
 /**
  * Loads and saves a list of servers using CFPreferences.
+ *
+ * Saves are not written immediately. Changes are journaled by server name and written
+ * together shortly afterwards, so e.g. detecting many external servers causes a single
+ * write to disk rather than one per server. Call synchronize to write immediately.
  */
 @interface PGServerDataStore : NSObject
 
 @property (nonatomic, weak) PGServerController *serverController;
 
-/// List of saved servers, ordered by name
+/**
+ * @param appID the CFPreferences domain to save servers in, e.g. a scratch domain for benchmarks
+ */
+- (instancetype)initWithAppID:(NSString *)appID;
+
+/// List of saved servers, ordered by name. Creates all servers not yet created - use serverWithName: to create just one.
 @property (nonatomic, strong, readonly) NSArray *servers;
 
 /**
@@ -47,7 +56,7 @@
 - (void)loadServers;
 
 /**
- * Ensures saved servers are synchronized to disk
+ * Writes any pending changes, and ensures saved servers are synchronized to disk
  */
 - (void)synchronize;
 
@@ -98,4 +107,45 @@
  */
 - (void)removeAllServers;
 
+/**
+ * Writes the last-known status, pid and resource usage of each server to a small cache file,
+ * so it can be shown as soon as the servers are next loaded, before any status checks finish.
+ *
+ * @return YES if succeeded
+ */
+- (BOOL)saveStatusSnapshot;
+
+/**
+ * Applies the snapshot written by saveStatusSnapshot to loaded servers whose status is not
+ * yet known. Only the servers named in the snapshot are created. Ignored if the system has restarted since it was written, as pids are no
+ * longer valid. Restored statuses are only a starting point - they should be checked.
+ *
+ * @return the number of servers restored
+ */
+- (NSUInteger)restoreStatusSnapshot;
+
+/**
+ * Adds the servers listed in a manifest file, then saves them all in a single write.
+ *
+ * The manifest is JSON Lines - one object per line, with a Name and the same keys as
+ * server properties. Blank lines and lines starting with # are skipped. The file is read
+ * in chunks, and each batch of lines is parsed and validated in parallel. Names that
+ * clash with existing servers get (1), (2), (3), etc. added, as for addServerWithName:.
+ *
+ * Malformed lines and invalid servers are skipped. If reading fails part-way, the servers
+ * read so far are kept. Either way, error describes what was skipped.
+ *
+ * The file is read and parsed on a background thread. The servers are added, and completion
+ * called, on the main thread - with the added servers in file order, or nil if the file could
+ * not be opened.
+ */
+- (void)importServersFromFile:(NSString *)path completion:(void(^)(NSArray<PGServer *> *servers, NSString *error))completion;
+
+/**
+ * Writes the saveable servers to a manifest file that can be read by importServersFromFile:completion:.
+ *
+ * @return YES if succeeded
+ */
+- (BOOL)exportServers:(NSArray<PGServer *> *)servers toFile:(NSString *)path error:(NSString **)error;
+
 @end
@@ -25,6 +25,84 @@
 //
 
 #import "PGServerDataStore.h"
+#ifdef __APPLE__
+#import <sys/sysctl.h>
+#endif
+
+#pragma mark - Constants
+
+/// Bytes read from a manifest file at a time
+#define PGServerDataStoreImportChunkSize (64 * 1024)
+
+/// Manifest lines parsed and validated together in parallel
+#define PGServerDataStoreImportBatchSize 256
+
+/// Records the format of the saved servers, for future migrations
+static NSString *const PGServerDataStoreVersionKey = @"StoreVersion";
+
+/// Status snapshot keys
+static NSString *const PGServerSnapshotBootTimeKey = @"BootTime";
+static NSString *const PGServerSnapshotServersKey = @"Servers";
+static NSString *const PGServerSnapshotStatusKey = @"Status";
+static NSString *const PGServerSnapshotPidKey = @"Pid";
+static NSString *const PGServerSnapshotErrorKey = @"Error";
+static NSString *const PGServerSnapshotUsageKey = @"Usage";
+
+/// Snapshot boot times differing by more than this are from a different boot
+#define PGServerSnapshotBootTimeTolerance 5.0
+
+/// Time the system booted, in seconds since reference date, or 0 if unknown.
+/// Note: not derived from systemUptime, which excludes time asleep.
+static inline NSTimeInterval
+SystemBootTime(void)
+{
+#ifdef __APPLE__
+    struct timeval boottime;
+    size_t size = sizeof(boottime);
+    int mib[2] = { CTL_KERN, KERN_BOOTTIME };
+    if (sysctl(mib, 2, &boottime, &size, NULL, 0) != 0 || boottime.tv_sec == 0) return 0;
+    return boottime.tv_sec + boottime.tv_usec / 1e6 - NSTimeIntervalSince1970;
+#else
+    // Whole seconds only, well within the tolerance
+    FILE *file = fopen("/proc/stat", "r");
+    if (!file) return 0;
+    char line[256];
+    long long boottime = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "btime %lld", &boottime) == 1) break;
+    }
+    fclose(file);
+    return boottime > 0 ? boottime - NSTimeIntervalSince1970 : 0;
+#endif
+}
+
+/// Same order as caseInsensitiveCompare:, but never equal for different names
+static NSComparisonResult
+CompareNames(NSString *name1, NSString *name2)
+{
+    NSComparisonResult result = [name1 caseInsensitiveCompare:name2];
+    return result != NSOrderedSame ? result : [name1 compare:name2];
+}
+
+/// Splits a name of the form "Prefix (n)" into its prefix and number. Otherwise number is 0.
+static NSString *
+SplitNumberedName(NSString *name, NSUInteger *number)
+{
+    *number = 0;
+    if (![name hasSuffix:@")"]) return name;
+    
+    NSRange open = [name rangeOfString:@" (" options:NSBackwardsSearch];
+    if (open.location == NSNotFound || open.location == 0) return name;
+    
+    NSString *digits = [name substringWithRange:NSMakeRange(NSMaxRange(open), name.length - NSMaxRange(open) - 1)];
+    if (digits.length == 0 || digits.length > 9 || [digits hasPrefix:@"0"]) return name;
+    if ([digits rangeOfCharacterFromSet:[NSCharacterSet decimalDigitCharacterSet].invertedSet].location != NSNotFound) return name;
+    
+    *number = (NSUInteger)digits.integerValue;
+    return [name substringToIndex:open.location];
+}
+
+
 
 #pragma mark - Interfaces
 
@@ -36,12 +114,60 @@
 /// Used to keep track of last-saved name for server
 @property (nonatomic, strong) NSMutableDictionary *namesCache;
 
-/// Used to cache servers by name
+/// Used to cache servers by name. NSNull if saved, but not yet created from its properties.
 @property (nonatomic, strong) NSMutableDictionary *serversCache;
 
 /// Used to return ordered servers list externally
 @property (nonatomic, strong) NSMutableArray *serversOrderedByName;
 
+/// All names in serversCache, kept sorted case-insensitively
+@property (nonatomic, strong) NSMutableArray<NSString *> *sortedNames;
+
+/// Numbers in use for "Prefix (n)" names, keyed by prefix. 0 means the prefix itself.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableIndexSet *> *nameNumbers;
+
+/// Changes not yet written - properties to save, or NSNull to remove, keyed by name
+@property (nonatomic, strong) NSMutableDictionary *pendingChanges;
+
+/// If YES, pending changes will be written shortly
+@property (nonatomic) BOOL flushScheduled;
+
+/**
+ * Adds the name to the sorted names and name numbers. Binary search, no re-sort.
+ */
+- (void)addName:(NSString *)name;
+
+/**
+ * Removes the name from the sorted names and name numbers.
+ */
+- (void)removeName:(NSString *)name;
+
+/**
+ * Creates servers from their saved properties, for names not yet created.
+ */
+- (void)materializeServersWithNames:(NSArray *)names;
+
+/**
+ * Journals the properties to be saved for the server name, or nil to remove it.
+ */
+- (void)setPendingProperties:(NSDictionary *)properties forName:(NSString *)name;
+
+/**
+ * Writes all pending changes to CFPreferences and synchronizes to disk.
+ */
+- (void)flush;
+
+/**
+ * Parses and validates manifest lines in parallel, collecting the resulting servers in order.
+ * Thread-safe - the servers are not added to the store.
+ */
+- (void)parseServersFromLines:(NSArray<NSData *> *)lines firstLine:(NSUInteger)firstLine into:(NSMutableArray *)servers errors:(NSMutableArray<NSString *> *)errors;
+
+/**
+ * Adds parsed servers with unique names, then saves them all in a single write.
+ */
+- (void)addImportedServers:(NSArray<PGServer *> *)servers;
+
 /**
  * Gets the next available unique server name for the specified prefix.
  */
@@ -56,12 +182,20 @@
 @implementation PGServerDataStore
 
 - (id)init
+{
+    return [self initWithAppID:[NSString stringWithFormat:@"%@.%@", PGPrefsAppID, @"servers"]];
+}
+
+- (instancetype)initWithAppID:(NSString *)appID
 {
     self = [super init];
     if (self) {
         self.namesCache = [NSMutableDictionary dictionary];
         self.serversCache = [NSMutableDictionary dictionary];
-        self.data = [[PGData alloc] initWithAppID:[NSString stringWithFormat:@"%@.%@", PGPrefsAppID, @"servers"]];
+        self.sortedNames = [NSMutableArray array];
+        self.nameNumbers = [NSMutableDictionary dictionary];
+        self.pendingChanges = [NSMutableDictionary dictionary];
+        self.data = [[PGData alloc] initWithAppID:appID];
     }
     return self;
 }
@@ -70,42 +204,52 @@
 {
     if (self.serversOrderedByName != nil) return self.serversOrderedByName;
     
-    // Generate ordered servers list
-    NSMutableArray *result = [NSMutableArray arrayWithCapacity:MAX(1,self.serversCache.count)];
-    NSArray *orderedNames = [self.serversCache.allKeys sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)];
-    for (NSString *name in orderedNames) [result addObject:self.serversCache[name]];
+    // Create any servers not yet created, in one batch
+    NSArray *unmaterialized = [self.serversCache allKeysForObject:[NSNull null]];
+    if (unmaterialized.count > 0) [self materializeServersWithNames:unmaterialized];
+    
+    // Generate ordered servers list - names are already sorted
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:MAX(1,self.sortedNames.count)];
+    for (NSString *name in self.sortedNames) [result addObject:self.serversCache[name]];
     
-    DLog(@"Servers: %@", orderedNames);
+    DLog(@"Servers: %@", self.sortedNames);
     
     return self.serversOrderedByName = result;
 }
 
 - (void)loadServers
 {
+    // Don't lose unwritten changes
+    [self flush];
+    
     [self clearCache];
     
-    NSDictionary *servers = [self.data allData];
-    if (servers.count == 0) return;
+    // Version - only ever increases, so an older app doesn't misread a newer store
+    NSArray *names = [self.data allKeys];
+    NSInteger version = [self.data numberForKey:PGServerDataStoreVersionKey].integerValue;
+    if (version > PGServerDataStoreVersion) {
+        DLog(@"Warning - server store version %ld is newer than %d", (long)version, PGServerDataStoreVersion);
+    }
     
-    for (NSString *name in servers.allKeys) {
-        
-        // Create the server
-        PGServer *server = [self.serverController serverFromProperties:servers[name] name:name domain:PGPrefsAppID];
-        if (!server) continue;
-        
-        // Cache
-        [self addToCache:server];
+    // Only names are loaded - servers are created when first needed
+    for (NSString *name in names) {
+        if (![name isKindOfClass:[NSString class]]) continue;
+        if ([name isEqualToString:PGServerDataStoreVersionKey]) continue;
+        [self addName:name];
+        self.serversCache[name] = [NSNull null];
     }
-
 }
 
 - (void)synchronize
 {
-    [self.data synchronize];
+    if (self.pendingChanges.count > 0) [self flush];
+    else [self.data synchronize];
 }
 
 - (PGServer *)serverWithName:(NSString *)name
 {
+    if (!name) return nil;
+    if (self.serversCache[name] == [NSNull null]) [self materializeServersWithNames:@[name]];
     return self.serversCache[name];
 }
 
@@ -128,8 +272,7 @@
     
     [self addToCache:server];
     
-    [self.data setData:server.properties forKey:name];
-    [self.data synchronize];
+    [self setPendingProperties:server.properties forName:name];
     
     return server;
 }
@@ -150,10 +293,7 @@
         // Remove old name
         if (server.saveable) {
             NSString *oldName = self.namesCache[server.uid];
-            if (NonBlank(oldName)) {
-                [self.data removeKey:oldName];
-                [self.data synchronize];
-            }
+            if (NonBlank(oldName)) [self setPendingProperties:nil forName:oldName];
         }
         [self removeFromCache:server];
         
@@ -162,10 +302,7 @@
     }
     
     DLog(@"%@", server);
-    if (server.saveable) {
-        [self.data setData:server.properties forKey:server.name];
-        [self.data synchronize];
-    }
+    if (server.saveable) [self setPendingProperties:server.properties forName:server.name];
     
     return YES;
 }
@@ -175,10 +312,7 @@
     if (!server) return;
     if (!NonBlank(server.name)) return;
     
-    if (server.saveable) {
-        [self.data removeKey:server.name];
-        [self.data synchronize];
-    }
+    if (server.saveable) [self setPendingProperties:nil forName:server.name];
 
     [self removeFromCache:server];
 }
@@ -188,19 +322,327 @@
     NSArray *names = self.serversCache.allKeys;
     if (names.count == 0) return;
     
-    [self.data removeKeys:names];
-    [self.data synchronize];
+    for (NSString *name in names) [self setPendingProperties:nil forName:name];
 
     [self clearCache];
 }
 
+- (BOOL)saveStatusSnapshot
+{
+    NSArray *servers = self.servers;
+    NSMutableDictionary *snapshots = [NSMutableDictionary dictionaryWithCapacity:servers.count];
+    for (PGServer *server in servers) {
+        
+        // Only settled statuses are worth showing next time
+        if (!NonBlank(server.name)) continue;
+        if (server.status != PGServerStarted && server.status != PGServerStopped) continue;
+        
+        NSMutableDictionary *snapshot = [NSMutableDictionary dictionaryWithCapacity:4];
+        snapshot[PGServerSnapshotStatusKey] = @(server.status);
+        if (server.pid > 0) snapshot[PGServerSnapshotPidKey] = @(server.pid);
+        if (NonBlank(server.error)) snapshot[PGServerSnapshotErrorKey] = server.error;
+        
+        // Latest usage, as time, cpu time, cpu %, memory, files, backends
+        PGProcessUsage usage;
+        if (server.status == PGServerStarted && [server.usageHistory latestUsage:&usage]) {
+            snapshot[PGServerSnapshotUsageKey] = @[@(usage.time), @(usage.cpuTime), @(usage.cpuPercent), @(usage.residentBytes), @(usage.openFiles), @(usage.children)];
+        }
+        snapshots[server.name] = snapshot;
+    }
+    
+    NSDictionary *contents = @{ PGServerSnapshotBootTimeKey: @(SystemBootTime()), PGServerSnapshotServersKey: snapshots };
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:contents format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    NSString *path = [PGServerStatusSnapshotFile stringByExpandingTildeInPath];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    return [data writeToFile:path atomically:YES];
+}
+
+- (NSUInteger)restoreStatusSnapshot
+{
+    NSData *data = [NSData dataWithContentsOfFile:[PGServerStatusSnapshotFile stringByExpandingTildeInPath]];
+    if (!data) return 0;
+    NSDictionary *contents = ToDictionary([NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:nil]);
+    
+    // Restarted - pids belong to other processes now
+    NSTimeInterval bootTime = [ToString(contents[PGServerSnapshotBootTimeKey]) doubleValue];
+    if (bootTime == 0 || fabs(bootTime - SystemBootTime()) > PGServerSnapshotBootTimeTolerance) return 0;
+    
+    // Only servers named in the snapshot are created, in one batch
+    NSDictionary *snapshots = ToDictionary(contents[PGServerSnapshotServersKey]);
+    NSMutableArray *unmaterialized = [NSMutableArray arrayWithCapacity:snapshots.count];
+    for (NSString *name in snapshots) {
+        if (self.serversCache[name] == [NSNull null]) [unmaterialized addObject:name];
+    }
+    if (unmaterialized.count > 0) [self materializeServersWithNames:unmaterialized];
+    
+    NSUInteger result = 0;
+    for (NSString *name in snapshots) {
+        PGServer *server = [self serverWithName:name];
+        if (!server || server.status != PGServerStatusUnknown) continue;
+        
+        NSDictionary *snapshot = ToDictionary(snapshots[name]);
+        PGServerStatus status = [ToString(snapshot[PGServerSnapshotStatusKey]) integerValue];
+        if (status != PGServerStarted && status != PGServerStopped) continue;
+        
+        server.status = status;
+        server.pid = [ToString(snapshot[PGServerSnapshotPidKey]) integerValue];
+        server.error = ToString(snapshot[PGServerSnapshotErrorKey]);
+        
+        NSArray *usage = ToArray(snapshot[PGServerSnapshotUsageKey]);
+        if (usage.count == 6) {
+            [server.usageHistory restoreUsage:(PGProcessUsage){
+                .time = [usage[0] doubleValue],
+                .cpuTime = [usage[1] doubleValue],
+                .cpuPercent = [usage[2] doubleValue],
+                .residentBytes = [usage[3] unsignedLongLongValue],
+                .openFiles = [usage[4] integerValue],
+                .children = [usage[5] integerValue]
+            }];
+        }
+        result++;
+    }
+    return result;
+}
+
+- (void)importServersFromFile:(NSString *)path completion:(void (^)(NSArray<PGServer *> *, NSString *))completion
+{
+    mustBeMainThread();
+    
+    // Read and parse in the background - only adding the servers touches the store
+    BackgroundThread(^{
+        NSInputStream *stream = [NSInputStream inputStreamWithFileAtPath:[path stringByExpandingTildeInPath]];
+        [stream open];
+        if (!stream || stream.streamStatus == NSStreamStatusError) {
+            NSString *error = [NSString stringWithFormat:@"Cannot read file: %@", stream.streamError.localizedDescription ?: path];
+            MainThread(^{ if (completion) completion(nil, error); });
+            return;
+        }
+        
+        NSMutableArray *result = [NSMutableArray array];
+        NSMutableArray<NSString *> *errors = [NSMutableArray array];
+        NSUInteger lineNumber = 1;
+        NSMutableArray<NSData *> *lines = [NSMutableArray arrayWithCapacity:PGServerDataStoreImportBatchSize];
+        NSMutableData *carry = [NSMutableData data];
+        uint8_t *buffer = malloc(PGServerDataStoreImportChunkSize);
+        
+        // Split into lines, a chunk at a time
+        NSInteger length;
+        while ((length = [stream read:buffer maxLength:PGServerDataStoreImportChunkSize]) > 0) {
+            NSUInteger start = 0;
+            for (NSUInteger i = 0; i < (NSUInteger)length; i++) {
+                if (buffer[i] != '\n') continue;
+                [carry appendBytes:buffer + start length:i - start];
+                [lines addObject:[carry copy]];
+                carry.length = 0;
+                start = i + 1;
+                
+                if (lines.count < PGServerDataStoreImportBatchSize) continue;
+                [self parseServersFromLines:lines firstLine:lineNumber into:result errors:errors];
+                lineNumber += lines.count;
+                [lines removeAllObjects];
+            }
+            [carry appendBytes:buffer + start length:(NSUInteger)length - start];
+        }
+        free(buffer);
+        
+        // Read failed - keep the servers read so far, but not a partial line
+        if (length < 0) {
+            [errors addObject:[NSString stringWithFormat:@"Cannot read file after line %lu: %@", (unsigned long)(lineNumber + lines.count - 1), stream.streamError.localizedDescription ?: path]];
+            [self parseServersFromLines:lines firstLine:lineNumber into:result errors:errors];
+            
+        // Last line might not end with a newline
+        } else {
+            if (carry.length > 0) [lines addObject:carry];
+            [self parseServersFromLines:lines firstLine:lineNumber into:result errors:errors];
+        }
+        [stream close];
+        
+        DLog(@"Imported %lu servers from %@, %lu errors", (unsigned long)result.count, path, (unsigned long)errors.count);
+        
+        NSString *error = errors.count > 0 ? [errors componentsJoinedByString:@"\n"] : nil;
+        MainThread(^{
+            [self addImportedServers:result];
+            if (completion) completion(result, error);
+        });
+    });
+}
+
+- (BOOL)exportServers:(NSArray<PGServer *> *)servers toFile:(NSString *)path error:(NSString **)error
+{
+    NSOutputStream *stream = [NSOutputStream outputStreamToFileAtPath:[path stringByExpandingTildeInPath] append:NO];
+    [stream open];
+    if (!stream || stream.streamStatus == NSStreamStatusError) {
+        if (error) *error = [NSString stringWithFormat:@"Cannot write file: %@", stream.streamError.localizedDescription ?: path];
+        return NO;
+    }
+    
+    // One server per line, written as it is converted
+    static const uint8_t newline = '\n';
+    for (PGServer *server in servers) {
+        if (!server.saveable) continue;
+        
+        NSMutableDictionary *properties = [server.properties mutableCopy];
+        properties[PGServerNameKey] = server.name;
+        
+        NSData *line = [NSJSONSerialization dataWithJSONObject:properties options:NSJSONWritingSortedKeys error:nil];
+        if (!line ||
+            [stream write:line.bytes maxLength:line.length] != (NSInteger)line.length ||
+            [stream write:&newline maxLength:1] != 1) {
+            if (error) *error = [NSString stringWithFormat:@"Cannot write file: %@", stream.streamError.localizedDescription ?: path];
+            [stream close];
+            return NO;
+        }
+    }
+    
+    [stream close];
+    return YES;
+}
+
 
 
 #pragma mark Private
 
+- (void)parseServersFromLines:(NSArray<NSData *> *)lines firstLine:(NSUInteger)firstLine into:(NSMutableArray *)servers errors:(NSMutableArray<NSString *> *)errors
+{
+    if (lines.count == 0) return;
+    
+    // Parse and validate in parallel - each line only touches its own server
+    PGServerController *serverController = self.serverController;
+    NSMutableArray *parsed = [NSMutableArray arrayWithCapacity:lines.count];
+    NSMutableArray *lineErrors = [NSMutableArray arrayWithCapacity:lines.count];
+    for (NSUInteger i = 0; i < lines.count; i++) [parsed addObject:[NSNull null]];
+    for (NSUInteger i = 0; i < lines.count; i++) [lineErrors addObject:[NSNull null]];
+    NSArray<NSString *> *numericKeys = @[PGServerLogMaxSizeKey, PGServerLogMaxAgeKey, PGServerLogMaxTotalSizeKey, PGServerShutdownTimeoutKey];
+    dispatch_apply(lines.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        NSData *line = lines[i];
+        
+        // Skip blank lines and comments
+        const char *bytes = line.bytes;
+        NSUInteger start = 0;
+        while (start < line.length && isspace((unsigned char)bytes[start])) start++;
+        if (start == line.length || bytes[start] == '#') return;
+        
+        // Parse
+        NSDictionary *object = [NSJSONSerialization JSONObjectWithData:line options:0 error:nil];
+        NSString *lineError = nil;
+        if (![object isKindOfClass:[NSDictionary class]]) {
+            lineError = [NSString stringWithFormat:@"Line %lu: not a JSON object", (unsigned long)(firstLine + i)];
+        } else {
+            for (NSString *key in numericKeys) {
+                if (!object[key] || ToNumber(object[key])) continue;
+                lineError = [NSString stringWithFormat:@"Line %lu: %@ is not a number", (unsigned long)(firstLine + i), key];
+                break;
+            }
+        }
+        if (lineError) {
+            @synchronized (parsed) {
+                lineErrors[i] = lineError;
+            }
+            return;
+        }
+        
+        // Missing settings are left blank, and always an internal server
+        NSMutableDictionary *properties = [object mutableCopy];
+        NSString *name = TrimToNil(ToString(properties[PGServerNameKey])) ?: PGServerDefaultName;
+        [properties removeObjectsForKeys:@[PGServerNameKey, PGServerDomainKey]];
+        for (NSString *key in @[PGServerUsernameKey, PGServerBinDirectoryKey, PGServerDataDirectoryKey, PGServerLogFileKey, PGServerPortKey]) {
+            if (!properties[key]) properties[key] = @"";
+        }
+        if (!properties[PGServerStartupKey]) properties[PGServerStartupKey] = PGServerStartupManualName;
+        
+        // Validate
+        PGServer *server = [serverController serverFromProperties:properties name:name domain:PGPrefsAppID];
+        @synchronized (parsed) {
+            if (server) parsed[i] = server;
+            else lineErrors[i] = [NSString stringWithFormat:@"Line %lu: invalid server settings", (unsigned long)(firstLine + i)];
+        }
+    });
+    
+    for (id lineError in lineErrors) {
+        if (lineError != [NSNull null]) [errors addObject:lineError];
+    }
+    for (PGServer *server in parsed) {
+        if (server != (id)[NSNull null]) [servers addObject:server];
+    }
+}
+
+- (void)addImportedServers:(NSArray<PGServer *> *)servers
+{
+    if (servers.count == 0) return;
+    
+    // Unique names and journal, in file order
+    for (PGServer *server in servers) {
+        NSString *name = [self unusedServerNameWithPrefix:server.name];
+        [self.serverController setName:name forServer:server];
+        
+        [self addToCache:server];
+        [self setPendingProperties:server.properties forName:server.name];
+    }
+    
+    // Single write for all servers
+    [self flush];
+}
+
+- (void)materializeServersWithNames:(NSArray *)names
+{
+    NSDictionary *data = [self.data dataForKeys:names];
+    for (NSString *name in names) {
+        
+        // Create the server
+        PGServer *server = [self.serverController serverFromProperties:data[name] name:name domain:PGPrefsAppID];
+        
+        // Not a valid server
+        if (!server) {
+            [self removeName:name];
+            [self.serversCache removeObjectForKey:name];
+            continue;
+        }
+        
+        // Cache
+        [self addToCache:server];
+    }
+}
+- (void)setPendingProperties:(NSDictionary *)properties forName:(NSString *)name
+{
+    if (!NonBlank(name)) return;
+    
+    // Latest change for a name wins
+    self.pendingChanges[name] = properties.count > 0 ? properties : [NSNull null];
+    
+    if (self.flushScheduled) return;
+    self.flushScheduled = YES;
+    
+    weakify(self);
+    MainThreadAfterDelay(PGServerDataStoreFlushDelay, ^{
+        strongify(self);
+        [self flush];
+    });
+}
+- (void)flush
+{
+    self.flushScheduled = NO;
+    if (self.pendingChanges.count == 0) return;
+    
+    // Split into saves and removes
+    NSMutableDictionary *saves = [NSMutableDictionary dictionaryWithCapacity:self.pendingChanges.count];
+    NSMutableArray *removes = [NSMutableArray array];
+    [self.pendingChanges enumerateKeysAndObjectsUsingBlock:^(NSString *name, id properties, BOOL *stop) {
+        if (properties == [NSNull null]) [removes addObject:name];
+        else saves[name] = properties;
+    }];
+    [self.pendingChanges removeAllObjects];
+    
+    // Saves before removes - on a rename, a crash mid-write leaves a duplicate, never a lost server
+    DLog(@"Saving %@, removing %@", saves.allKeys, removes);
+    [self.data setNumber:@(PGServerDataStoreVersion) forKey:PGServerDataStoreVersionKey];
+    [self.data setData:saves removeKeys:nil];
+    [self.data setData:nil removeKeys:removes];
+    [self.data synchronize];
+}
 - (void)addToCache:(PGServer *)server
 {
     if (!server) return;
+    if (!self.serversCache[server.name]) [self addName:server.name];
     self.namesCache[server.uid] = server.name;
     self.serversCache[server.name] = server;
     
@@ -211,7 +653,10 @@
     if (!server) return;
     NSString *nameInCache = self.namesCache[server.uid];
     [self.namesCache removeObjectForKey:server.uid];
-    if (nameInCache) [self.serversCache removeObjectForKey:nameInCache];
+    if (nameInCache) {
+        [self removeName:nameInCache];
+        [self.serversCache removeObjectForKey:nameInCache];
+    }
 
     self.serversOrderedByName = nil;
 }
@@ -219,9 +664,42 @@
 {
     [self.namesCache removeAllObjects];
     [self.serversCache removeAllObjects];
+    [self.sortedNames removeAllObjects];
+    [self.nameNumbers removeAllObjects];
     self.serversOrderedByName = nil;
 }
 
+- (void)addName:(NSString *)name
+{
+    // Sorted
+    NSUInteger index = [self.sortedNames indexOfObject:name inSortedRange:NSMakeRange(0, self.sortedNames.count) options:NSBinarySearchingInsertionIndex usingComparator:^NSComparisonResult(NSString *name1, NSString *name2) {
+        return CompareNames(name1, name2);
+    }];
+    [self.sortedNames insertObject:name atIndex:index];
+    
+    // Numbers
+    NSUInteger number;
+    NSString *prefix = SplitNumberedName(name, &number);
+    NSMutableIndexSet *numbers = self.nameNumbers[prefix];
+    if (!numbers) self.nameNumbers[prefix] = numbers = [NSMutableIndexSet indexSet];
+    [numbers addIndex:number];
+}
+- (void)removeName:(NSString *)name
+{
+    // Sorted
+    NSUInteger index = [self.sortedNames indexOfObject:name inSortedRange:NSMakeRange(0, self.sortedNames.count) options:NSBinarySearchingFirstEqual usingComparator:^NSComparisonResult(NSString *name1, NSString *name2) {
+        return CompareNames(name1, name2);
+    }];
+    if (index != NSNotFound) [self.sortedNames removeObjectAtIndex:index];
+    
+    // Numbers
+    NSUInteger number;
+    NSString *prefix = SplitNumberedName(name, &number);
+    NSMutableIndexSet *numbers = self.nameNumbers[prefix];
+    [numbers removeIndex:number];
+    if (numbers.count == 0) [self.nameNumbers removeObjectForKey:prefix];
+}
+
 - (NSString *)unusedServerNameWithPrefix:(NSString *)prefix
 {
     if (!NonBlank(prefix)) return prefix;
@@ -229,20 +707,13 @@
     // First, if no other servers exist with this prefix, then use it as-is
     if (!self.serversCache[prefix]) return prefix;
     
-    // Get the existing names with prefix
-    NSMutableDictionary *existingNames = [NSMutableDictionary dictionaryWithCapacity:self.servers.count];
-    for (PGServer *server in self.servers) {
-        if ([server.name hasPrefix:prefix]) existingNames[server.name] = [NSNull null];
-    }
-    
-    // Now cycle up from 1 until we find a free name
-    for (NSInteger i = 1; i < 10000; i++) {
-        NSString *name = [NSString stringWithFormat:@"%@ (%ld)", prefix, (long) i];
-        if (!existingNames[name]) return name;
-    }
-    
-    // Give up - use an error name
-    return @"*** ERRROR ***";
+    // Lowest unused number, skipping over used ranges rather than trying each number
+    __block NSUInteger number = 1;
+    [self.nameNumbers[prefix] enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        if (range.location > number) *stop = YES;
+        else number = MAX(number, NSMaxRange(range));
+    }];
+    return [NSString stringWithFormat:@"%@ (%lu)", prefix, (unsigned long) number];
 }
 
 @end
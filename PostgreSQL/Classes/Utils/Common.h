@@ -86,6 +86,17 @@ ToDictionary(id value)
     if (value == nil || value == [NSNull null] || ![value isKindOfClass:[NSDictionary class]]) return nil;
     return (NSDictionary *)value;
 }
+/// Return value converted to NSNumber, or nil if not a number or numeric string
+static inline NSNumber *
+ToNumber(id value)
+{
+    if ([value isKindOfClass:[NSNumber class]]) return (NSNumber *)value;
+    if (![value isKindOfClass:[NSString class]]) return nil;
+    NSScanner *scanner = [NSScanner scannerWithString:(NSString *)value];
+    double result = 0;
+    if (![scanner scanDouble:&result] || !scanner.atEnd) return nil;
+    return @(result);
+}
 /// Return value converted to BOOL
 static inline BOOL
 ToBOOL(id value)
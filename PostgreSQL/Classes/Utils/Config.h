@@ -30,21 +30,43 @@
 // App
 #define PGPrefsAppID @"org.postgresql.preferences"
 #define PGServersPollTime 5
+#define PGServersBulkActionMaxConcurrent 4
+#define PGServerDataStoreFlushDelay 0.5
+#define PGServerDataStoreVersion 1
+#define PGPrefsDisplayFrameTime (1.0/60.0)
+#define PGServerUsageHistoryCapacity 60
+#define PGServerFailureMaxMessages 3
+#define PGServerFailureMaxLogBytes (1024 * 1024)
+#define PGServerShutdownTimeout 5.0
+#define PGServerImmediateShutdownTimeout 2.0
+#define PGServerCheckpointTimeout 30
+#define PGAuthSessionRecheckInterval 30
+#define PGServerStartTimeout 10.0
+#define PGCommandLineDiscoverTimeout 2.0
 #define PGLaunchdDaemonForAllUsersAtBootDir @"/Library/LaunchDaemons"
 #define PGLaunchdDaemonForAllUsersAtLoginDir @"/Library/LaunchAgents"
 #define PGLaunchdDaemonForCurrentUserOnlyDir @"~/Library/LaunchAgents"
 #define PGLaunchdDaemonLogRootDir @"/Library/Logs/PostgreSQL"
 #define PGLaunchdDaemonLogUserDir @"~/Library/Logs/PostgreSQL"
+#define PGLogFileIndexDir @"~/Library/Caches/org.postgresql.preferences/LogIndex"
+#define PGServerStatusSnapshotFile @"~/Library/Caches/org.postgresql.preferences/ServerStatus.plist"
+#define PGLogRotationMaxSize (100ULL * 1024 * 1024)
+#define PGLogRotationMaxAge (7 * 24 * 60 * 60)
+#define PGLogRotationMaxTotalSize (1024ULL * 1024 * 1024)
 
 // Debugging
+#define PGLogEnabledKey @"DebugLog"
 #ifdef DEBUG
 #
 #   define LOG_FILE [NSHomeDirectory() stringByAppendingPathComponent:@"Library/Logs/PostgreSQL/org.postgresql.preferences.DEBUG.log"]
+#   define PGLogEnabledByDefault YES
 #   define PGPrefsMonitorServersEnabled NO
 #   define PGPrefsRefreshServersEnabled YES
 #
 #else /* !DEBUG */
 #
+#   define LOG_FILE [NSHomeDirectory() stringByAppendingPathComponent:@"Library/Logs/PostgreSQL/org.postgresql.preferences.log"]
+#   define PGLogEnabledByDefault NO
 #   define PGPrefsMonitorServersEnabled YES
 #   define PGPrefsRefreshServersEnabled NO
 #
@@ -79,6 +101,7 @@
 #define PGPrefsPane                  PG(PrefsPane)
 #define PGPrefsViewController        PG(PrefsViewController)
 #define PGPrefsController            PG(PrefsController)
+#define PGServersSnapshot            PG(ServersSnapshot)
 #define PGPrefsSegmentedControl      PG(PrefsSegmentedControl)
 #define PGPrefsToggleImageView       PG(PrefsToggleImageView)
 #define PGPrefsToggleButton          PG(PrefsToggleButton)
@@ -94,16 +117,24 @@
 #define PGPrefsCenteredTextView      PG(PrefsCenteredTextView)
 #define PGPrefsNonClickableTextField PG(PrefsNonClickableTextField)
 #define PGPrefsShowAndWaitPopover    PG(PrefsShowAndWaitPopover)
+#define PGPrefsServerState           PG(PrefsServerState)
+#define PGPrefsSparklineView         PG(PrefsSparklineView)
+#define PGPrefsLogWindow             PG(PrefsLogWindow)
 
 #define PGServer                     PG(Server)
 #define PGServerSettings             PG(ServerSettings)
 #define PGServerController           PG(ServerController)
 #define PGServerDelegate             PG(ServerDelegate)
+#define PGServerRequest              PG(ServerRequest)
+#define PGServerQueue                PG(ServerQueue)
+#define PGServerValidationPlan       PG(ServerValidationPlan)
 #define PGServerDataStore            PG(ServerDataStore)
 
 #define PGSearchController           PG(SearchController)
 #define PGSearchDelegate             PG(SearchDelegate)
 
+#define PGCommandLine                PG(CommandLine)
+
 #define PGServerDefaultName          PG(ServerDefaultName)
 #define PGServerNameKey              PG(ServerNameKey)
 #define PGServerDomainKey            PG(ServerDomainKey)
@@ -113,6 +144,12 @@
 #define PGServerLogFileKey           PG(ServerLogFileKey)
 #define PGServerPortKey              PG(ServerPortKey)
 #define PGServerStartupKey           PG(ServerStartupKey)
+#define PGServerLogMaxSizeKey        PG(ServerLogMaxSizeKey)
+#define PGServerLogMaxAgeKey         PG(ServerLogMaxAgeKey)
+#define PGServerLogMaxTotalSizeKey   PG(ServerLogMaxTotalSizeKey)
+#define PGServerShutdownKey          PG(ServerShutdownKey)
+#define PGServerCheckpointBeforeStopKey PG(ServerCheckpointBeforeStopKey)
+#define PGServerShutdownTimeoutKey   PG(ServerShutdownTimeoutKey)
 
 #define PGServerStartup              PG(ServerStartup)
 #define PGServerStartupManual        PG(ServerStartupManual)
@@ -122,6 +159,14 @@
 #define PGServerStartupAtBootName    PG(ServerStartupAtBootName)
 #define PGServerStartupAtLoginName   PG(ServerStartupAtLoginName)
 
+#define PGServerShutdown             PG(ServerShutdown)
+#define PGServerShutdownSmart        PG(ServerShutdownSmart)
+#define PGServerShutdownFast         PG(ServerShutdownFast)
+#define PGServerShutdownImmediate    PG(ServerShutdownImmediate)
+#define PGServerShutdownSmartName    PG(ServerShutdownSmartName)
+#define PGServerShutdownFastName     PG(ServerShutdownFastName)
+#define PGServerShutdownImmediateName PG(ServerShutdownImmediateName)
+
 #define PGServerStatus               PG(ServerStatus)
 #define PGServerStatusUnknown        PG(ServerStatusUnknown)
 #define PGServerStarting             PG(ServerStarting)
@@ -159,18 +204,33 @@
 
 #define PGAuth                       PG(Auth)
 #define PGAuthDelegate               PG(AuthDelegate)
+#define PGAuthSession                PG(AuthSession)
 #define PGAuthReasonKey              PG(AuthReasonKey)
 #define PGAuthReasonAction           PG(AuthReasonAction)
 #define PGAuthReasonTarget           PG(AuthReasonTarget)
 #define PGData                       PG(Data)
+#define PGFakeSystem                 PG(FakeSystem)
+#define PGFakeProcess                PG(FakeProcess)
+#define PGFakeJob                    PG(FakeJob)
 #define PGFile                       PG(File)
 #define PGLaunchd                    PG(Launchd)
+#define PGLaunchdBackend             PG(LaunchdBackend)
+#define PGLogFile                    PG(LogFile)
+#define PGLogFileDelegate            PG(LogFileDelegate)
+#define PGLogSeverity                PG(LogSeverity)
+#define PGLogRotator                 PG(LogRotator)
+#define PGRotatedLog                 PG(RotatedLog)
+#define PGLogRotationPolicy          PG(LogRotationPolicy)
 #define PGProcess                    PG(Process)
+#define PGProcessBackend             PG(ProcessBackend)
+#define PGProcessUsage               PG(ProcessUsage)
+#define PGProcessUsageHistory        PG(ProcessUsageHistory)
 #define PGRights                     PG(Rights)
 #define PGUser                       PG(User)
 #define PGFileType                   PG(FileType)
 #define PGFileNone                   PG(FileNone)
 #define PGFileFile                   PG(FileFile)
 #define PGFileDir                    PG(FileDir)
+#define PGFileUnknown                PG(FileUnknown)
 
 #endif /* PostgreSQL_Config_h */
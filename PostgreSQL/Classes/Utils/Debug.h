@@ -27,70 +27,37 @@
 #ifndef PostgreSQL_Debug_h
 #define PostgreSQL_Debug_h
 
-#ifdef DEBUG
-#
-static inline void DebugLog(NSString *logFile, const char *func, NSString* fmt, ...)
+/**
+ * Logging for debugging.
+ *
+ * DLog copies the time, thread, function, format and arguments into a fixed-size record in a ring
+ * buffer owned by the calling thread, without taking locks or formatting anything. A background
+ * queue drains the rings every so often, and formats and writes the messages to LOG_FILE.
+ *
+ * Strings and numbers are formatted later, but other objects are described straight away,
+ * as they may have changed or not be thread-safe by then. If a thread logs faster than the
+ * drainer, its messages are dropped (and counted) rather than blocking.
+ *
+ * Always enabled in DEBUG builds. Otherwise enabled by the DebugLog preference, and each DLog
+ * only costs a check of a flag.
+ */
+
+/// 1 if enabled, -1 if disabled, 0 if not yet checked
+extern int PGLogState;
+/// Checks the preference and sets PGLogState
+extern BOOL PGLogCheckEnabled(void);
+/// Use DLog
+extern void PGLogRecordMessage(const char *function, NSString *format, ...);
+/// Waits until all messages logged so far have been written. Called automatically at exit.
+extern void PGLogFlush(void);
+
+static inline BOOL
+PGLogIsEnabled(void)
 {
-    // Get log message args
-    va_list argList;
-    va_start(argList, fmt);
-    NSString* msg = [[NSString alloc] initWithFormat:fmt arguments:argList];
-    va_end(argList);
-    
-    // Format
-    static NSDateFormatter *dateFormatter = nil;
-    if (!dateFormatter) {
-        NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
-        formatter.dateFormat = @"yyyy-MM-dd HH:mm:ss.SSS";
-        dateFormatter = formatter;
-    }
-    NSString *formattedMsg =
-    [NSString stringWithFormat:
-     @"\n"
-     "-------------------------------------------------------------------------------------"
-     "\n[%@]                                     %@\n"
-     "-------------------------------------------------------------------------------------"
-     "\n\n%s\n"
-     "\n%@\n",
-     [dateFormatter stringFromDate:[NSDate date]],
-     [NSThread isMainThread] ? @"" : [NSString stringWithFormat:@"[Background:%p]", [NSThread currentThread]],
-     func,
-     msg];
-    
-    // Redirect stderr to file
-    if (logFile) {
-        // Create log dir
-        if (! [[NSFileManager defaultManager] fileExistsAtPath:logFile]) {
-            [[NSFileManager defaultManager] createDirectoryAtPath:[logFile stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
-        }
-        
-        // Redirect stderr
-        const char *PATH = [logFile fileSystemRepresentation];
-        freopen(PATH, "a", stderr);
-    }
-    
-    // Prevent garbled logs due to logging on multiple threads
-    static id synchronizer = nil;
-    id localSynchronizerRef = synchronizer ?: (synchronizer = [NSDate date]);
-    
-    // Log
-    @synchronized (localSynchronizerRef) {
-        fprintf(stderr, "%s", [formattedMsg UTF8String]);
-    }
-    fflush(stderr);
+    return PGLogState > 0 || (PGLogState == 0 && PGLogCheckEnabled());
 }
-#
-#   ifndef LOG_FILE
-#       define LOG_FILE nil
-#   endif
-#   define DLog(fmt, ...) DebugLog(LOG_FILE, __PRETTY_FUNCTION__, fmt, ##__VA_ARGS__)
-#   define IsLogging YES
-#
-#else /* ! DEBUG */
-#
-#   define DLog(...)
-#   define IsLogging NO
-#
-#endif /* DEBUG */
+
+#define DLog(fmt, ...) do { if (PGLogIsEnabled()) PGLogRecordMessage(__PRETTY_FUNCTION__, fmt, ##__VA_ARGS__); } while (0)
+#define IsLogging PGLogIsEnabled()
 
 #endif /* PostgreSQL_Debug_h */
@@ -0,0 +1,549 @@
+//
+//  Debug.m
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "Debug.h"
+#import <pthread.h>
+#import <stdatomic.h>
+#import <time.h>
+#ifndef __APPLE__
+#import <sys/syscall.h>
+#import <unistd.h>
+#endif
+
+/// Records in each thread's ring. Must be a power of two.
+#define PGLogRingCapacity 256
+/// Maximum arguments kept in a record. Messages with more are formatted when logged.
+#define PGLogMaxArgs 8
+/// How often the rings are drained, in seconds
+#define PGLogDrainInterval 0.1
+
+int PGLogState = 0;
+
+
+
+#pragma mark - Records
+
+typedef NS_ENUM(uint8_t, PGLogArgType) {
+    PGLogArgUnsupported = 0,
+    PGLogArgInt,
+    PGLogArgUnsigned,
+    PGLogArgChar,
+    PGLogArgDouble,
+    PGLogArgPointer,
+    PGLogArgObject,
+    PGLogArgCString,
+};
+
+typedef union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const void *p;
+} PGLogArg;
+
+/**
+ * One message, as logged. The format and object arguments are retained.
+ */
+typedef struct {
+    uint64_t time;
+    const char *function;
+    const void *format;
+    uint8_t count;
+    PGLogArgType types[PGLogMaxArgs];
+    PGLogArg args[PGLogMaxArgs];
+} PGLogRecord;
+
+/**
+ * Single producer (the owning thread), single consumer (the drainer) queue of records.
+ */
+typedef struct PGLogRing {
+    struct PGLogRing *next;
+    uint64_t thread;
+    BOOL mainThread;
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    _Atomic uint64_t dropped;
+    _Atomic bool finished;
+    PGLogRecord records[PGLogRingCapacity];
+} PGLogRing;
+
+/// All rings. Rings are only added at the head (by any thread) and only removed by the drainer.
+static _Atomic(PGLogRing *) Rings = NULL;
+static __thread PGLogRing *CurrentRing = NULL;
+static pthread_key_t RingKey;
+static dispatch_queue_t DrainQueue;
+static dispatch_source_t DrainTimer;
+
+static void PGLogStart(void);
+static void PGLogDrain(void);
+
+/// Release the retained parts of a record
+static void
+ReleaseRecord(PGLogRecord *record)
+{
+    if (record->format) CFRelease(record->format);
+    for (uint8_t i = 0; i < record->count; i++) {
+        if (record->types[i] >= PGLogArgObject && record->args[i].p) CFRelease(record->args[i].p);
+    }
+}
+
+
+
+#pragma mark - Format Parsing
+
+/**
+ * Parses the conversion following a '%', e.g. "-8.3lld".
+ *
+ * @return The type of the argument, or PGLogArgUnsupported. Length is set to the length of
+ * the conversion, and wide if the argument is 64-bit.
+ */
+static PGLogArgType
+ParseConversion(const char *spec, size_t *length, BOOL *wide)
+{
+    const char *c = spec;
+    *wide = NO;
+    
+    // Flags, width, precision - '*' not supported as it takes an argument
+    while (*c && strchr("-+ #0'", *c)) c++;
+    while (*c >= '0' && *c <= '9') c++;
+    if (*c == '.') {
+        c++;
+        while (*c >= '0' && *c <= '9') c++;
+    }
+    
+    // Length modifiers
+    if (*c == 'h') {
+        c++;
+        if (*c == 'h') c++;
+    } else if (*c == 'l' || *c == 'q' || *c == 'z' || *c == 't' || *c == 'j') {
+        *wide = YES;
+        c++;
+        if (*c == 'l') c++;
+    } else if (*c == 'L') {
+        return PGLogArgUnsupported;
+    }
+    
+    PGLogArgType result = PGLogArgUnsupported;
+    switch (*c) {
+        case 'd': case 'i': case 'D':
+            result = PGLogArgInt; break;
+        case 'u': case 'x': case 'X': case 'o': case 'U': case 'O':
+            result = PGLogArgUnsigned; break;
+        case 'c': case 'C':
+            result = PGLogArgChar; break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            result = PGLogArgDouble; break;
+        case 'p':
+            result = PGLogArgPointer; break;
+        case '@':
+            result = PGLogArgObject; break;
+        case 's':
+            result = PGLogArgCString; break;
+        default:
+            return PGLogArgUnsupported;
+    }
+    if (*c == 'D' || *c == 'U' || *c == 'O') *wide = YES;
+    *length = (size_t)(c - spec) + 1;
+    return result;
+}
+
+/// Fast path for constant strings, otherwise NULL
+static inline const char *
+FormatChars(const void *format)
+{
+    return CFStringGetCStringPtr((CFStringRef)format, kCFStringEncodingUTF8);
+}
+
+/// Release the arguments recorded so far. Always returns NO.
+static BOOL
+DiscardArgs(PGLogRecord *record)
+{
+    for (uint8_t i = 0; i < record->count; i++) {
+        if (record->types[i] >= PGLogArgObject && record->args[i].p) CFRelease(record->args[i].p);
+    }
+    record->count = 0;
+    return NO;
+}
+
+/**
+ * Reads the arguments into the record without formatting them.
+ *
+ * @return NO if the format can't be recorded, in which case the record has no arguments.
+ */
+static BOOL
+RecordArgs(PGLogRecord *record, const char *format, va_list args)
+{
+    record->count = 0;
+    for (const char *c = strchr(format, '%'); c; c = strchr(c, '%')) {
+        c++;
+        if (*c == '%') { c++; continue; }
+        
+        size_t length = 0;
+        BOOL wide = NO;
+        PGLogArgType type = ParseConversion(c, &length, &wide);
+        if (type == PGLogArgUnsupported || record->count == PGLogMaxArgs) return DiscardArgs(record);
+        c += length;
+        
+        PGLogArg *arg = &record->args[record->count];
+        switch (type) {
+            case PGLogArgInt:
+                arg->i = wide ? va_arg(args, int64_t) : va_arg(args, int);
+                break;
+            case PGLogArgUnsigned:
+                arg->u = wide ? va_arg(args, uint64_t) : va_arg(args, unsigned int);
+                break;
+            case PGLogArgChar:
+                arg->i = va_arg(args, int);
+                break;
+            case PGLogArgDouble:
+                arg->d = va_arg(args, double);
+                break;
+            case PGLogArgPointer:
+                arg->p = va_arg(args, void *);
+                break;
+            case PGLogArgObject: {
+                // Immutable strings and numbers can be formatted later - anything else now
+                id object = va_arg(args, id);
+                if ([object isKindOfClass:[NSString class]] || [object isKindOfClass:[NSNumber class]]) object = [object copy];
+                else if (object) object = [object description];
+                arg->p = object ? CFBridgingRetain(object) : NULL;
+                break;
+            }
+            case PGLogArgCString: {
+                const char *string = va_arg(args, const char *);
+                arg->p = string ? CFBridgingRetain([NSString stringWithUTF8String:string]) : NULL;
+                break;
+            }
+            default:
+                return DiscardArgs(record);
+        }
+        record->types[record->count++] = type;
+    }
+    return YES;
+}
+
+
+
+#pragma mark - Logging
+
+BOOL
+PGLogCheckEnabled(void)
+{
+    BOOL enabled = PGLogEnabledByDefault;
+    if (!enabled) {
+        Boolean exists = false;
+        enabled = CFPreferencesGetAppBooleanValue((__bridge CFStringRef)PGLogEnabledKey, (__bridge CFStringRef)PGPrefsAppID, &exists) && exists;
+    }
+    PGLogState = enabled ? 1 : -1;
+    return enabled;
+}
+
+/// Called on the owning thread when it exits. The drainer frees the ring once it is empty.
+static void
+FinishRing(void *ring)
+{
+    CurrentRing = NULL;
+    atomic_store_explicit(&((PGLogRing *)ring)->finished, true, memory_order_release);
+}
+
+static PGLogRing *
+CreateRing(void)
+{
+    PGLogStart();
+    
+    PGLogRing *ring = calloc(1, sizeof(PGLogRing));
+    if (!ring) return NULL;
+#ifdef __APPLE__
+    pthread_threadid_np(NULL, &ring->thread);
+    ring->mainThread = pthread_main_np() != 0;
+#else
+    ring->thread = (uint64_t)syscall(SYS_gettid);
+    ring->mainThread = ring->thread == (uint64_t)getpid();
+#endif
+    pthread_setspecific(RingKey, ring);
+    CurrentRing = ring;
+    
+    PGLogRing *next = atomic_load_explicit(&Rings, memory_order_relaxed);
+    do {
+        ring->next = next;
+    } while (!atomic_compare_exchange_weak_explicit(&Rings, &next, ring, memory_order_release, memory_order_relaxed));
+    return ring;
+}
+
+void
+PGLogRecordMessage(const char *function, NSString *format, ...)
+{
+    PGLogRing *ring = CurrentRing ?: CreateRing();
+    if (!ring) return;
+    
+    // Full - never block the caller
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= PGLogRingCapacity) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    
+    PGLogRecord *record = &ring->records[head & (PGLogRingCapacity - 1)];
+#ifdef __APPLE__
+    record->time = clock_gettime_nsec_np(CLOCK_REALTIME);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record->time = (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+#endif
+    record->function = function;
+    
+    va_list args, argsCopy;
+    va_start(args, format);
+    va_copy(argsCopy, args);
+    const char *chars = format ? FormatChars((__bridge CFStringRef)format) : NULL;
+    if (chars && RecordArgs(record, chars, args)) {
+        record->format = CFBridgingRetain([format copy]);
+        
+    // Can't defer - format now
+    } else {
+        NSString *message = format ? [[NSString alloc] initWithFormat:format arguments:argsCopy] : nil;
+        record->format = CFBridgingRetain(@"%@");
+        record->count = 1;
+        record->types[0] = PGLogArgObject;
+        record->args[0].p = message ? CFBridgingRetain(message) : NULL;
+    }
+    va_end(argsCopy);
+    va_end(args);
+    
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void
+PGLogFlush(void)
+{
+    if (!DrainQueue) return;
+    dispatch_sync(DrainQueue, ^{
+        PGLogDrain();
+    });
+}
+
+static void
+PGLogStart(void)
+{
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        pthread_key_create(&RingKey, FinishRing);
+        
+        DrainQueue = dispatch_queue_create("org.postgresql.preferences.log", DISPATCH_QUEUE_SERIAL);
+        DrainTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, DrainQueue);
+        uint64_t interval = (uint64_t)(PGLogDrainInterval * NSEC_PER_SEC);
+        dispatch_source_set_timer(DrainTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, interval / 2);
+        dispatch_source_set_event_handler(DrainTimer, ^{
+            PGLogDrain();
+        });
+        dispatch_resume(DrainTimer);
+        
+        atexit(PGLogFlush);
+    });
+}
+
+
+
+#pragma mark - Draining
+
+/**
+ * A drained record, with the thread that logged it.
+ */
+typedef struct {
+    PGLogRecord record;
+    uint64_t thread;
+    BOOL mainThread;
+} PGLogEntry;
+
+static int
+CompareEntries(const void *a, const void *b)
+{
+    uint64_t time1 = ((const PGLogEntry *)a)->record.time;
+    uint64_t time2 = ((const PGLogEntry *)b)->record.time;
+    return time1 < time2 ? -1 : (time1 > time2 ? 1 : 0);
+}
+
+static void
+AppendBytes(NSMutableString *string, const char *bytes, size_t length)
+{
+    if (length == 0) return;
+    NSString *append = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (append) [string appendString:append];
+}
+
+/// The message with the arguments formatted into it
+static NSString *
+FormatMessage(PGLogRecord *record)
+{
+    NSString *format = (__bridge NSString *)record->format;
+    const char *chars = FormatChars(record->format) ?: format.UTF8String;
+    if (!chars) return @"";
+    
+    NSMutableString *result = [NSMutableString stringWithCapacity:strlen(chars)];
+    const char *literal = chars;
+    uint8_t index = 0;
+    for (const char *c = strchr(chars, '%'); c; c = strchr(literal, '%')) {
+        AppendBytes(result, literal, (size_t)(c - literal));
+        if (c[1] == '%') {
+            [result appendString:@"%"];
+            literal = c + 2;
+            continue;
+        }
+        
+        size_t length = 0;
+        BOOL wide = NO;
+        PGLogArgType type = ParseConversion(c + 1, &length, &wide);
+        literal = c + 1 + length;
+        if (type == PGLogArgUnsupported || index >= record->count) break;
+        PGLogArg arg = record->args[index++];
+        
+        // Objects ignore flags & width
+        if (type == PGLogArgObject || type == PGLogArgCString) {
+            [result appendString:arg.p ? [(__bridge id)arg.p description] : @"(null)"];
+            continue;
+        }
+        
+        // Rewrite length modifiers for 64-bit arguments, e.g. "%-8hd" as "%-8lld"
+        char spec[32];
+        size_t specLength = 0;
+        for (const char *s = c; s < literal - 1 && specLength < sizeof(spec) - 4; s++) {
+            if (!strchr("hlqztj", *s)) spec[specLength++] = *s;
+        }
+        if (type == PGLogArgInt || type == PGLogArgUnsigned) {
+            spec[specLength++] = 'l';
+            spec[specLength++] = 'l';
+        }
+        char conversion = literal[-1];
+        spec[specLength++] = strchr("DUO", conversion) ? (char)tolower(conversion) : conversion;
+        spec[specLength] = '\0';
+        NSString *specString = @(spec);
+        
+        switch (type) {
+            case PGLogArgInt: [result appendFormat:specString, (long long)arg.i]; break;
+            case PGLogArgUnsigned: [result appendFormat:specString, (unsigned long long)arg.u]; break;
+            case PGLogArgChar: [result appendFormat:specString, (int)arg.i]; break;
+            case PGLogArgDouble: [result appendFormat:specString, arg.d]; break;
+            case PGLogArgPointer: [result appendFormat:specString, arg.p]; break;
+            default: break;
+        }
+    }
+    if (literal) AppendBytes(result, literal, strlen(literal));
+    return result;
+}
+
+static FILE *
+OutputFile(void)
+{
+    static FILE *output = NULL;
+    if (output) return output;
+    
+#ifdef LOG_FILE
+    NSString *path = LOG_FILE;
+    if (path) {
+        [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+        output = fopen(path.fileSystemRepresentation, "a");
+    }
+#endif
+    if (!output) output = stderr;
+    return output;
+}
+
+/// Formats and writes all records logged so far. Only called on the drain queue.
+static void
+PGLogDrain(void)
+{
+    static PGLogEntry *entries = NULL;
+    static size_t capacity = 0;
+    size_t count = 0;
+    NSMutableString *output = [NSMutableString string];
+    
+    // Copy out records first, to free up space in the rings quickly
+    PGLogRing *previous = NULL;
+    PGLogRing *ring = atomic_load_explicit(&Rings, memory_order_acquire);
+    while (ring) {
+        bool finished = atomic_load_explicit(&ring->finished, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (count + (head - tail) > capacity) {
+            size_t newCapacity = MAX(capacity * 2, count + (head - tail));
+            PGLogEntry *newEntries = realloc(entries, newCapacity * sizeof(PGLogEntry));
+            if (!newEntries) break;
+            entries = newEntries;
+            capacity = newCapacity;
+        }
+        for (; tail < head; tail++) {
+            entries[count++] = (PGLogEntry){ ring->records[tail & (PGLogRingCapacity - 1)], ring->thread, ring->mainThread };
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        
+        uint64_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+        if (dropped > 0) [output appendFormat:@"\n[Dropped %llu messages from thread %llu]\n", dropped, ring->thread];
+        
+        // Only the drainer unlinks, and new rings are only added before the head
+        PGLogRing *next = ring->next;
+        if (finished && previous) {
+            previous->next = next;
+            free(ring);
+        } else {
+            previous = ring;
+        }
+        ring = next;
+    }
+    if (count == 0 && output.length == 0) return;
+    
+    qsort(entries, count, sizeof(PGLogEntry), CompareEntries);
+    
+    static NSDateFormatter *dateFormatter = nil;
+    if (!dateFormatter) {
+        dateFormatter = [[NSDateFormatter alloc] init];
+        dateFormatter.dateFormat = @"yyyy-MM-dd HH:mm:ss.SSS";
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        @autoreleasepool {
+            PGLogEntry *entry = &entries[i];
+            NSDate *date = [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)entry->record.time / NSEC_PER_SEC];
+            [output appendFormat:
+             @"\n"
+             "-------------------------------------------------------------------------------------"
+             "\n[%@]                                     %@\n"
+             "-------------------------------------------------------------------------------------"
+             "\n\n%s\n"
+             "\n%@\n",
+             [dateFormatter stringFromDate:date],
+             entry->mainThread ? @"" : [NSString stringWithFormat:@"[Background:%llu]", entry->thread],
+             entry->record.function ?: "",
+             FormatMessage(&entry->record)];
+            ReleaseRecord(&entry->record);
+        }
+    }
+    
+    FILE *file = OutputFile();
+    fputs(output.UTF8String, file);
+    fflush(file);
+}
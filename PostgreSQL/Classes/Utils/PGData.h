@@ -54,6 +54,12 @@
  * @return dictionary of (string,dictionary) entries
  */
 - (NSDictionary *)allData;
+/**
+ * Loads (string,dictionary) entries for only the specified keys in CFPreferences
+ *
+ * @return dictionary of (string,dictionary) entries, omitting missing keys
+ */
+- (NSDictionary *)dataForKeys:(NSArray *)keys;
 /**
  * Loads all (string,primitive) entries in CFPreferences
  * (Primitive means number or string)
@@ -93,6 +99,11 @@
  * Removes multiple keys in CFPreferences
  */
 - (void)removeKeys:(NSArray *)keys;
+/**
+ * Creates, overwrites and removes multiple keys in CFPreferences in a single call.
+ * Keys to set and keys to remove should not overlap.
+ */
+- (void)setData:(NSDictionary<NSString *, NSDictionary *> *)values removeKeys:(NSArray *)keys;
 /**
  * Synchronizes CFPreferences changes to disk
  */
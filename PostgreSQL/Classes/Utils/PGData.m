@@ -26,10 +26,14 @@
 
 #import "PGData.h"
 
+/// Maximum number of values copied from CFPreferences at a time
+#define PGDataPageSize 100
+
 #pragma mark - Interfaces
 
 @interface PGData ()
 - (NSDictionary *)allPreferencesWithClass:(Class)valueClass orClass:(Class)valueClass2;
+- (NSDictionary *)preferencesForKeys:(NSArray *)keys withClass:(Class)valueClass orClass:(Class)valueClass2;
 - (id)preferenceForKey:(NSString *)key;
 - (void)setPreference:(id)value forKey:(NSString *)key;
 @end
@@ -58,37 +62,36 @@
 }
 
 - (NSDictionary *)allPreferencesWithClass:(Class)valueClass orClass:(Class)valueClass2
+{
+    return [self preferencesForKeys:self.allKeys withClass:valueClass orClass:valueClass2];
+}
+
+- (NSDictionary *)preferencesForKeys:(NSArray *)keys withClass:(Class)valueClass orClass:(Class)valueClass2
 {
     CFStringRef appIDRef = self.appID ? (__bridge CFStringRef) self.appID : kCFPreferencesCurrentApplication;
     
-    // Get all keys
-    NSArray *keys = self.allKeys;
-    
     // Give up if array empty
     if (keys.count == 0) return nil;
     
-    // Put a sensible maximum limit on the number of keys, just in case!
-    if (keys.count > 100) {
-        DLog(@"ERROR: Too many keys: %@", keys);
-        keys = [keys subarrayWithRange:NSMakeRange(0, 100)];
-    }
-    
-    // Get all values for keys
-    NSDictionary *data = (NSDictionary *)CFBridgingRelease(CFPreferencesCopyMultiple((__bridge CFPropertyListRef) keys, appIDRef, kCFPreferencesCurrentUser, kCFPreferencesAnyHost));
-    if (data.count == 0) return nil;
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:keys.count];
     
-    // Filter out anything not of form (string,dictionary)
-    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:data.count];
-    for (id key in data.allKeys) {
-        id value = data[key];
+    // Get values a page at a time, so a large store doesn't need one huge copy
+    for (NSUInteger start = 0; start < keys.count; start += PGDataPageSize) {
+        NSArray *page = [keys subarrayWithRange:NSMakeRange(start, MIN(PGDataPageSize, keys.count - start))];
+        NSDictionary *data = (NSDictionary *)CFBridgingRelease(CFPreferencesCopyMultiple((__bridge CFArrayRef) page, appIDRef, kCFPreferencesCurrentUser, kCFPreferencesAnyHost));
         
-        if (![key isKindOfClass:[NSString class]]) continue;
-        if (!( // Note: Nil with capital 'N' means nil class
-              (valueClass != Nil && [value isKindOfClass:valueClass]) ||
-              (valueClass2 != Nil && [value isKindOfClass:valueClass2])
-        )) continue;
-        
-        result[key] = value;
+        // Filter out anything not of form (string,dictionary)
+        for (id key in data.allKeys) {
+            id value = data[key];
+            
+            if (![key isKindOfClass:[NSString class]]) continue;
+            if (!( // Note: Nil with capital 'N' means nil class
+                  (valueClass != Nil && [value isKindOfClass:valueClass]) ||
+                  (valueClass2 != Nil && [value isKindOfClass:valueClass2])
+            )) continue;
+            
+            result[key] = value;
+        }
     }
     
     return result.count == 0 ? nil : result;
@@ -100,6 +103,12 @@
     return [self allPreferencesWithClass:[NSDictionary class] orClass:Nil];
 }
 
+- (NSDictionary *)dataForKeys:(NSArray *)keys
+{
+    // Note: Nil with capital 'N' means nil class
+    return [self preferencesForKeys:keys withClass:[NSDictionary class] orClass:Nil];
+}
+
 - (NSDictionary *)allPrimitives
 {
     return [self allPreferencesWithClass:[NSString class] orClass:[NSNumber class]];
@@ -174,6 +183,17 @@
     CFPreferencesSetMultiple(NULL, keysRef, appIDRef, kCFPreferencesCurrentUser, kCFPreferencesAnyHost);
 }
 
+- (void)setData:(NSDictionary<NSString *, NSDictionary *> *)values removeKeys:(NSArray *)keys
+{
+    if (values.count == 0 && keys.count == 0) return;
+    
+    CFStringRef appIDRef = self.appID ? (__bridge CFStringRef) self.appID : kCFPreferencesCurrentApplication;
+    CFDictionaryRef valuesRef = values.count > 0 ? (__bridge CFDictionaryRef) values : NULL;
+    CFArrayRef keysRef = keys.count > 0 ? (__bridge CFArrayRef) keys : NULL;
+    
+    CFPreferencesSetMultiple(valuesRef, keysRef, appIDRef, kCFPreferencesCurrentUser, kCFPreferencesAnyHost);
+}
+
 - (void)synchronize
 {
     CFStringRef appIDRef = self.appID ? (__bridge CFStringRef) self.appID : kCFPreferencesCurrentApplication;
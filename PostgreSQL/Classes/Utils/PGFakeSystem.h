@@ -0,0 +1,101 @@
+//
+//  PGFakeSystem.h
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "PGLaunchd.h"
+#import "PGProcess.h"
+
+#pragma mark - PGFakeSystem
+
+/**
+ * In-memory launchd and process table with a virtual clock, so that the server controller
+ * can be run deterministically without real jobs or postgres processes.
+ *
+ * Every operation advances the clock by its configured latency instead of blocking, and is
+ * counted, so callers can check the time, subprocesses and syscalls an action costs. Loaded
+ * jobs spawn a process that launchd reports once the spawn latency has passed, and that its
+ * postmaster.pid lists as ready once the ready latency has passed after that. Signals make
+ * the process exit after the latency for the matching shutdown mode.
+ *
+ * Note: there is a single clock, so time spent by concurrent actions is added together.
+ * Run actions one at a time for wall-time budgets.
+ */
+@interface PGFakeSystem : NSObject <PGLaunchdBackend, PGProcessBackend>
+
+/// Cost of running launchctl, i.e. bootstrap, bootout or kickstart
+@property (nonatomic) NSTimeInterval launchctlLatency;
+/// Cost of asking launchd for loaded jobs
+@property (nonatomic) NSTimeInterval lookupLatency;
+/// Cost of running ps
+@property (nonatomic) NSTimeInterval psLatency;
+/// Cost of a kill or proc_pidinfo syscall
+@property (nonatomic) NSTimeInterval syscallLatency;
+/// Time from loading a job until launchd reports its pid
+@property (nonatomic) NSTimeInterval spawnLatency;
+/// Time from the pid being reported until postmaster.pid says the server is ready
+@property (nonatomic) NSTimeInterval readyLatency;
+/// Time from a signal until the process exits, for smart (SIGTERM), fast (SIGINT) and immediate (SIGQUIT) shutdown
+@property (nonatomic) NSTimeInterval smartShutdownLatency;
+@property (nonatomic) NSTimeInterval fastShutdownLatency;
+@property (nonatomic) NSTimeInterval immediateShutdownLatency;
+
+/// Number of calls of each operation, keyed by the system call or command it replaces
+@property (nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *counts;
+/// Number of operations that would have run a subprocess, e.g. launchctl or ps
+@property (nonatomic, readonly) NSUInteger subprocesses;
+/// Number of operations that would have made a system call, e.g. kill or SMJobCopyDictionary
+@property (nonatomic, readonly) NSUInteger syscalls;
+
+/**
+ * Makes PGLaunchd and PGProcess use this fake.
+ */
+- (void)install;
+
+/**
+ * Makes PGLaunchd and PGProcess use the real system again.
+ */
+- (void)uninstall;
+
+/**
+ * Zeroes all operation counts.
+ */
+- (void)resetCounts;
+
+/**
+ * Adds a job that is loaded and already running, e.g. as if started before the test.
+ *
+ * @return the pid of the job's process
+ */
+- (NSInteger)addDaemon:(NSDictionary *)daemon forRootUser:(BOOL)root;
+
+/**
+ * Adds a running process that was not started by launchd.
+ *
+ * @return the pid of the process
+ */
+- (NSInteger)addProcessWithCommand:(NSString *)command uid:(NSInteger)uid;
+
+@end
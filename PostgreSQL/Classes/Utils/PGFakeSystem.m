@@ -0,0 +1,452 @@
+//
+//  PGFakeSystem.m
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "PGFakeSystem.h"
+#import <signal.h>
+
+#define PGFakeSystemFirstPid 1000
+
+#pragma mark - Interfaces
+
+/**
+ * A process in the fake process table.
+ */
+@interface PGFakeProcess : NSObject
+@property (nonatomic) NSInteger pid;
+@property (nonatomic) NSInteger uid;
+@property (nonatomic, strong) NSString *command;
+/// Virtual time the process becomes visible, i.e. has finished starting
+@property (nonatomic) NSTimeInterval startTime;
+/// Virtual time postmaster.pid lists the process as ready for connections
+@property (nonatomic) NSTimeInterval readyTime;
+/// Virtual time the process exits, or INFINITY if not signalled
+@property (nonatomic) NSTimeInterval exitTime;
+@end
+
+/**
+ * A job in the fake launchd.
+ */
+@interface PGFakeJob : NSObject
+@property (nonatomic, strong) NSDictionary *daemon;
+@property (nonatomic) BOOL root;
+@property (nonatomic, strong) PGFakeProcess *process;
+@end
+
+@interface PGFakeSystem()
+
+/// Access only while synchronized on self
+@property (nonatomic) NSTimeInterval clock;
+@property (nonatomic) NSInteger nextPid;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, PGFakeJob *> *jobs;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, PGFakeProcess *> *processes;
+@property (nonatomic, strong) NSCountedSet<NSString *> *operations;
+@property (nonatomic) NSUInteger subprocessCount;
+@property (nonatomic) NSUInteger syscallCount;
+
+/**
+ * Counts the operation and advances the clock by its latency. Call while synchronized.
+ */
+- (void)runSubprocess:(NSString *)name latency:(NSTimeInterval)latency;
+- (void)runSyscall:(NSString *)name latency:(NSTimeInterval)latency;
+
+/**
+ * Removes processes that have exited by now, clearing them from their jobs. Call while synchronized.
+ */
+- (void)reap;
+
+/**
+ * Creates a process that becomes visible after the delay, and ready the ready latency later.
+ * Without delay, it is visible and ready at once, i.e. was started before. Call while synchronized.
+ */
+- (PGFakeProcess *)spawnProcessWithCommand:(NSString *)command uid:(NSInteger)uid delay:(NSTimeInterval)delay;
+
+/**
+ * The job's properties as reported by launchd. Call while synchronized.
+ */
+- (NSDictionary *)daemonForJob:(PGFakeJob *)job;
+
+@end
+
+
+
+#pragma mark - PGFakeProcess
+
+@implementation PGFakeProcess
+@end
+
+
+
+#pragma mark - PGFakeJob
+
+@implementation PGFakeJob
+@end
+
+
+
+#pragma mark - PGFakeSystem
+
+@implementation PGFakeSystem
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _launchctlLatency = 0.02;
+        _lookupLatency = 0.001;
+        _psLatency = 0.015;
+        _syscallLatency = 0.0001;
+        _spawnLatency = 0.3;
+        _readyLatency = 0.05;
+        _smartShutdownLatency = 0.5;
+        _fastShutdownLatency = 0.2;
+        _immediateShutdownLatency = 0.05;
+        _nextPid = PGFakeSystemFirstPid;
+        _jobs = [NSMutableDictionary dictionary];
+        _processes = [NSMutableDictionary dictionary];
+        _operations = [NSCountedSet set];
+    }
+    return self;
+}
+
+
+
+#pragma mark Main Methods
+
+- (void)install
+{
+    PGLaunchd.backend = self;
+    PGProcess.backend = self;
+}
+
+- (void)uninstall
+{
+    if (PGLaunchd.backend == self) PGLaunchd.backend = nil;
+    if (PGProcess.backend == self) PGProcess.backend = nil;
+}
+
+- (void)resetCounts
+{
+    @synchronized(self) {
+        [self.operations removeAllObjects];
+        self.subprocessCount = 0;
+        self.syscallCount = 0;
+    }
+}
+
+- (NSDictionary<NSString *,NSNumber *> *)counts
+{
+    @synchronized(self) {
+        NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:self.operations.count];
+        for (NSString *name in self.operations) result[name] = @([self.operations countForObject:name]);
+        return result;
+    }
+}
+
+- (NSUInteger)subprocesses
+{
+    @synchronized(self) { return self.subprocessCount; }
+}
+
+- (NSUInteger)syscalls
+{
+    @synchronized(self) { return self.syscallCount; }
+}
+
+- (NSInteger)addDaemon:(NSDictionary *)daemon forRootUser:(BOOL)root
+{
+    NSString *label = ToString(daemon[@"Label"]);
+    if (!label) return 0;
+    
+    @synchronized(self) {
+        PGFakeJob *job = [[PGFakeJob alloc] init];
+        job.daemon = daemon;
+        job.root = root;
+        PGUser *user = [PGUser userWithUsername:ToString(daemon[@"UserName"])] ?: (root ? PGUser.root : PGUser.current);
+        job.process = [self spawnProcessWithCommand:[ToArray(daemon[@"ProgramArguments"]) componentsJoinedByString:@" "] uid:user.uid delay:0];
+        self.jobs[[NSString stringWithFormat:@"%@/%@", @(root), label]] = job;
+        return job.process.pid;
+    }
+}
+
+- (NSInteger)addProcessWithCommand:(NSString *)command uid:(NSInteger)uid
+{
+    @synchronized(self) {
+        return [self spawnProcessWithCommand:command uid:uid delay:0].pid;
+    }
+}
+
+
+
+#pragma mark PGProcessBackend
+
+- (NSTimeInterval)now
+{
+    @synchronized(self) { return self.clock; }
+}
+
+- (void)sleepForTimeInterval:(NSTimeInterval)interval
+{
+    @synchronized(self) { self.clock += MAX(0, interval); }
+}
+
+- (PGProcess *)runningProcessWithPid:(NSInteger)pid
+{
+    @synchronized(self) {
+        [self runSubprocess:@"ps" latency:self.psLatency];
+        PGFakeProcess *process = self.processes[@(pid)];
+        if (!process || process.startTime > self.clock) return nil;
+        return [[PGProcess alloc] initWithPid:process.pid ppid:1 uid:process.uid command:process.command];
+    }
+}
+
+- (NSArray *)runningProcessesWithNameLike:(NSString *)pattern
+{
+    NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:pattern ?: @"" options:NSRegularExpressionCaseInsensitive error:nil];
+    
+    @synchronized(self) {
+        [self runSubprocess:@"ps" latency:self.psLatency];
+        NSMutableArray *result = [NSMutableArray array];
+        for (PGFakeProcess *process in self.processes.allValues) {
+            if (process.startTime > self.clock) continue;
+            if (regex && ![regex firstMatchInString:process.command options:0 range:NSMakeRange(0, process.command.length)]) continue;
+            [result addObject:[[PGProcess alloc] initWithPid:process.pid ppid:1 uid:process.uid command:process.command]];
+        }
+        return result.count == 0 ? nil : result;
+    }
+}
+
+- (BOOL)sampleUsage:(PGProcessUsage *)usage forPid:(NSInteger)pid
+{
+    @synchronized(self) {
+        [self runSyscall:@"proc_pidinfo" latency:self.syscallLatency];
+        PGFakeProcess *process = self.processes[@(pid)];
+        if (!process || process.startTime > self.clock) return NO;
+        *usage = (PGProcessUsage){ .time = self.clock };
+        return YES;
+    }
+}
+
+- (BOOL)waitForPid:(NSInteger)pid toExitWithTimeout:(NSTimeInterval)timeout
+{
+    @synchronized(self) {
+        [self runSyscall:@"kevent" latency:0];
+        PGFakeProcess *process = self.processes[@(pid)];
+        if (!process) return YES;
+        
+        // Exits in time - wake up when it does
+        if (process.exitTime <= self.clock + timeout) {
+            self.clock = MAX(self.clock, process.exitTime);
+            [self reap];
+            return YES;
+        }
+        
+        // Timed out
+        self.clock += MAX(0, timeout);
+        return NO;
+    }
+}
+
+- (BOOL)signal:(int)signal pid:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
+{
+    @synchronized(self) {
+        if (root) [self runSubprocess:@"kill" latency:self.psLatency];
+        else [self runSyscall:@"kill" latency:self.syscallLatency];
+        
+        PGFakeProcess *process = self.processes[@(pid)];
+        if (!process) return YES;
+        
+        NSTimeInterval latency;
+        switch (signal) {
+            case SIGTERM: latency = self.smartShutdownLatency; break;
+            case SIGINT: latency = self.fastShutdownLatency; break;
+            case SIGQUIT: latency = self.immediateShutdownLatency; break;
+            case SIGKILL: latency = 0; break;
+            default: return YES;
+        }
+        process.exitTime = MIN(process.exitTime, self.clock + latency);
+        [self reap];
+        return YES;
+    }
+}
+
+- (BOOL)postmasterIsReadyWithDataDirectory:(NSString *)dataDirectory pid:(NSInteger)pid
+{
+    @synchronized(self) {
+        [self runSyscall:@"open postmaster.pid" latency:self.syscallLatency];
+        PGFakeProcess *process = self.processes[@(pid)];
+        if (!process) return NO;
+        return process.readyTime <= self.clock && process.exitTime > self.clock;
+    }
+}
+
+
+
+#pragma mark PGLaunchdBackend
+
+- (NSArray *)loadedDaemonsWithNameLike:(NSString *)pattern forRootUser:(BOOL)root
+{
+    @synchronized(self) {
+        [self runSyscall:@"SMCopyAllJobDictionaries" latency:self.lookupLatency];
+        NSMutableArray *result = [NSMutableArray arrayWithCapacity:self.jobs.count];
+        for (PGFakeJob *job in self.jobs.allValues) {
+            if (job.root == root) [result addObject:[self daemonForJob:job]];
+        }
+        if (result.count == 0) return nil;
+        return pattern ? [result filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"Label LIKE[cd] %@", pattern]] : result;
+    }
+}
+
+- (NSDictionary *)loadedDaemonWithName:(NSString *)name forRootUser:(BOOL)root
+{
+    @synchronized(self) {
+        [self runSyscall:@"SMJobCopyDictionary" latency:self.lookupLatency];
+        PGFakeJob *job = self.jobs[[NSString stringWithFormat:@"%@/%@", @(root), name]];
+        return job ? [self daemonForJob:job] : nil;
+    }
+}
+
+- (BOOL)startDaemonWithFile:(NSString *)file forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
+{
+    NSDictionary *daemon = [NSDictionary dictionaryWithContentsOfFile:file];
+    NSString *label = ToString(daemon[@"Label"]);
+    
+    @synchronized(self) {
+        [self runSubprocess:@"launchctl bootstrap" latency:self.launchctlLatency];
+        if (!label) {
+            if (error) *error = [NSString stringWithFormat:@"Not a valid daemon property file: %@", file];
+            return NO;
+        }
+        NSString *key = [NSString stringWithFormat:@"%@/%@", @(root), label];
+        if (self.jobs[key]) {
+            if (error) *error = @"Bootstrap failed: 5: Input/output error";
+            return NO;
+        }
+        
+        PGFakeJob *job = [[PGFakeJob alloc] init];
+        job.daemon = daemon;
+        job.root = root;
+        PGUser *user = [PGUser userWithUsername:ToString(daemon[@"UserName"])] ?: (root ? PGUser.root : PGUser.current);
+        job.process = [self spawnProcessWithCommand:[ToArray(daemon[@"ProgramArguments"]) componentsJoinedByString:@" "] uid:user.uid delay:self.spawnLatency];
+        self.jobs[key] = job;
+        return YES;
+    }
+}
+
+- (BOOL)restartDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
+{
+    @synchronized(self) {
+        [self runSubprocess:@"launchctl kickstart" latency:self.launchctlLatency];
+        PGFakeJob *job = self.jobs[[NSString stringWithFormat:@"%@/%@", @(root), name]];
+        if (!job) {
+            if (error) *error = @"Could not find service";
+            return NO;
+        }
+        
+        // Already running - kickstart without -k leaves it alone
+        PGFakeProcess *old = job.process;
+        if (old && self.processes[@(old.pid)]) return YES;
+        job.process = [self spawnProcessWithCommand:[ToArray(job.daemon[@"ProgramArguments"]) componentsJoinedByString:@" "] uid:(old ? old.uid : PGUser.current.uid) delay:self.spawnLatency];
+        return YES;
+    }
+}
+
+- (BOOL)stopDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
+{
+    // Silently ignore if daemon not loaded
+    if (![self loadedDaemonWithName:name forRootUser:root]) return YES;
+    
+    @synchronized(self) {
+        [self runSubprocess:@"launchctl bootout" latency:self.launchctlLatency];
+        NSString *key = [NSString stringWithFormat:@"%@/%@", @(root), name];
+        PGFakeJob *job = self.jobs[key];
+        [self.jobs removeObjectForKey:key];
+        
+        // Launchd asks the process to terminate
+        PGFakeProcess *process = job.process;
+        if (process) process.exitTime = MIN(process.exitTime, self.clock + self.smartShutdownLatency);
+        [self reap];
+        return YES;
+    }
+}
+
+
+
+#pragma mark Private
+
+- (void)runSubprocess:(NSString *)name latency:(NSTimeInterval)latency
+{
+    [self.operations addObject:name];
+    self.subprocessCount++;
+    self.clock += latency;
+    [self reap];
+}
+
+- (void)runSyscall:(NSString *)name latency:(NSTimeInterval)latency
+{
+    [self.operations addObject:name];
+    self.syscallCount++;
+    self.clock += latency;
+    [self reap];
+}
+
+- (void)reap
+{
+    NSTimeInterval now = self.clock;
+    NSArray *exited = [self.processes keysOfEntriesPassingTest:^BOOL(NSNumber *pid, PGFakeProcess *process, BOOL *stop) {
+        return process.exitTime <= now;
+    }].allObjects;
+    if (exited.count == 0) return;
+    
+    [self.processes removeObjectsForKeys:exited];
+    for (PGFakeJob *job in self.jobs.allValues) {
+        if (job.process && job.process.exitTime <= now) job.process = nil;
+    }
+}
+
+- (PGFakeProcess *)spawnProcessWithCommand:(NSString *)command uid:(NSInteger)uid delay:(NSTimeInterval)delay
+{
+    PGFakeProcess *process = [[PGFakeProcess alloc] init];
+    process.pid = self.nextPid++;
+    process.uid = uid;
+    process.command = command ?: @"";
+    process.startTime = self.clock + delay;
+    process.readyTime = delay > 0 ? process.startTime + self.readyLatency : process.startTime;
+    process.exitTime = INFINITY;
+    self.processes[@(process.pid)] = process;
+    return process;
+}
+
+- (NSDictionary *)daemonForJob:(PGFakeJob *)job
+{
+    PGFakeProcess *process = job.process;
+    if (!process || process.startTime > self.clock) return job.daemon;
+    
+    NSMutableDictionary *result = [job.daemon mutableCopy];
+    result[@"PID"] = @(process.pid);
+    return result;
+}
+
+@end
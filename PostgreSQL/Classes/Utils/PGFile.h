@@ -32,7 +32,9 @@ NS_ASSUME_NONNULL_BEGIN
 typedef NS_ENUM(NSUInteger, PGFileType) {
     PGFileNone = 0,
     PGFileFile,
-    PGFileDir
+    PGFileDir,
+    /// Could not be checked, e.g. authorization was refused
+    PGFileUnknown
 };
 
 static inline NSString *
@@ -42,6 +44,7 @@ NSStringFromPGFileType(PGFileType type)
         case PGFileNone: return @"none";
         case PGFileFile: return @"file";
         case PGFileDir: return @"directory";
+        case PGFileUnknown: return @"unknown";
     }
 };
 
@@ -62,6 +65,13 @@ NSStringFromPGFileType(PGFileType type)
                           auth:(nullable PGAuth *)authorization
                          error:(NSString *_Nullable __autoreleasing *_Nullable)error;
 
+/// Determine if each path is file or dir or nothing, keyed by path as given. Paths that cannot
+/// be checked without authorization are all checked by a single authorized command, and are
+/// PGFileUnknown if that command is refused or fails.
++ (NSDictionary<NSString *, NSNumber *> *)typesOfFilesAtPaths:(NSArray<NSString *> *)paths
+                                                         auth:(nullable PGAuth *)authorization
+                                                        error:(NSString *_Nullable __autoreleasing *_Nullable)error;
+
 /// Checks if file exists without authorization.
 + (BOOL)fileExists:(nullable NSString *)file;
 
@@ -107,7 +117,8 @@ NSStringFromPGFileType(PGFileType type)
                contents:(nullable NSDictionary *)contents
                   error:(NSString *_Nullable __autoreleasing *_Nullable)error;
 
-/// Writes a property list file using a dictionary as its content.
+/// Writes a binary property list file using a dictionary as its content.
+/// Skipped if the file already has the same content and owner, so no authorization is needed.
 + (BOOL)createPlistFile:(NSString *)file
                contents:(nullable NSDictionary *)contents
                    user:(nullable PGUser *)user
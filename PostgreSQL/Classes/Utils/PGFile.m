@@ -25,6 +25,35 @@
 //
 
 #import "PGFile.h"
+#import <sys/stat.h>
+
+#pragma mark - Constants / Functions
+
+/// Modification time in nanoseconds since 1970
+static inline long long
+ModifiedTime(const struct stat *info)
+{
+#ifdef __APPLE__
+    return info->st_mtimespec.tv_sec * NSEC_PER_SEC + info->st_mtimespec.tv_nsec;
+#else
+    return info->st_mtim.tv_sec * NSEC_PER_SEC + info->st_mtim.tv_nsec;
+#endif
+}
+
+/// 64-bit FNV-1a hash
+static uint64_t
+HashData(NSData *data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const uint8_t *bytes = data.bytes;
+    for (NSUInteger i = 0; i < data.length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
 
 #pragma mark - PGFile
 
@@ -98,6 +127,57 @@
     
     return result;
 }
++ (NSDictionary<NSString *,NSNumber *> *)typesOfFilesAtPaths:(NSArray<NSString *> *)paths auth:(PGAuth *)auth error:(NSString *__autoreleasing *)outerr
+{
+    if (outerr) { *outerr = nil; }
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:paths.count];
+    NSMutableArray *unreadable = [NSMutableArray array];
+    
+    // Try without authorization
+    for (NSString *path in paths) {
+        if (result[path]) continue;
+        NSString *validPath = [self validatePath:path errorIfBlank:NO error:nil];
+        
+        BOOL isDirectory = NO;
+        if (!validPath) {
+            result[path] = @(PGFileNone);
+        } else if ([self.fileManager fileExistsAtPath:validPath isDirectory:&isDirectory]) {
+            result[path] = @(isDirectory ? PGFileDir : PGFileFile);
+        } else if ([self inReadableDir:validPath]) {
+            result[path] = @(PGFileNone);
+        } else {
+            result[path] = @(PGFileUnknown);
+            [unreadable addObject:path];
+        }
+    }
+    if (unreadable.count == 0) return result;
+    
+    // Authorization required - one command for all, printing one letter per path
+    NSMutableString *command = [NSMutableString stringWithString:@"for path in"];
+    for (NSString *path in unreadable) {
+        NSString *validPath = [self validatePath:path errorIfBlank:NO error:nil];
+        NSString *escaped = validPath;
+        for (NSString *special in @[@"\\", @"\"", @"$", @"`"]) {
+            escaped = [escaped stringByReplacingOccurrencesOfString:special withString:[@"\\" stringByAppendingString:special]];
+        }
+        [command appendFormat:@" \"%@\"", escaped];
+    }
+    [command appendString:@"; do if [ -f \"$path\" ]; then echo f; elif [ -d \"$path\" ]; then echo d; else echo n; fi; done"];
+    
+    NSString *output = nil;
+    if (![PGProcess runShellCommand:command forRootUser:YES auth:auth output:&output error:outerr]) return result;
+    
+    // Note line endings may be converted by the authorizing script
+    NSArray<NSString *> *lines = [output componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]];
+    [unreadable enumerateObjectsUsingBlock:^(NSString *path, NSUInteger i, BOOL *stop) {
+        if (i >= lines.count) { *stop = YES; return; }
+        if ([lines[i] hasPrefix:@"f"]) { result[path] = @(PGFileFile); }
+        else if ([lines[i] hasPrefix:@"d"]) { result[path] = @(PGFileDir); }
+        else if ([lines[i] hasPrefix:@"n"]) { result[path] = @(PGFileNone); }
+    }];
+    
+    return result;
+}
 + (BOOL)fileExists:(NSString *)file
 {
     return [self fileExists:file user:nil auth:nil error:nil];
@@ -110,6 +190,7 @@
             if (outerr) { *outerr = [NSString stringWithFormat:@"Invalid file: %@", file]; }
             return NO;
         case PGFileNone: return NO;
+        case PGFileUnknown: return NO;
         case PGFileFile: return YES;
     }
 }
@@ -126,6 +207,7 @@
             if (outerr) { *outerr = [NSString stringWithFormat:@"Invalid dir: %@", dir]; }
             return NO;
         case PGFileNone: return NO;
+        case PGFileUnknown: return NO;
         case PGFileDir: return YES;
     }
 }
@@ -203,6 +285,21 @@
         return NO;
     }
     if (!contents) { contents = @{}; }
+    
+    // Serialize in memory
+    NSError *writeError = nil;
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:contents format:NSPropertyListBinaryFormat_v1_0 options:0 error:&writeError];
+    if (data.length == 0) {
+        if (outerr) { *outerr = [NSString stringWithFormat:@"Error creating property file: %@", (writeError ?: @"invalid data")]; }
+        return NO;
+    }
+    
+    // Unchanged - no need to write, so no need for authorization either
+    uint64_t hash = HashData(data);
+    if ([self file:path hasHash:hash length:data.length user:user]) {
+        DLog(@"Unchanged: %@", path);
+        return YES;
+    }
 
     // Parent dir must exist
     if (![self createDir:path.stringByDeletingLastPathComponent user:user auth:auth error:outerr]) { return NO; }
@@ -211,15 +308,9 @@
     __block BOOL result = NO;
     [self temporaryFileWithExtension:path.pathExtension usingBlock:^(NSString *temporaryPath) {
         
-        // Write output to temporary file
-        NSOutputStream *tempStream = [NSOutputStream outputStreamToFileAtPath:temporaryPath append:NO];
-        [tempStream open];
-        NSError *writeError = nil;
-        NSInteger numberOfBytes = [NSPropertyListSerialization writePropertyList:contents toStream:tempStream format:NSPropertyListXMLFormat_v1_0 options:0 error:&writeError];
-        
         // Write failed
-        if (numberOfBytes == 0) {
-            if (outerr) { *outerr = [NSString stringWithFormat:@"Error creating property file: %@", (writeError ?: [NSString stringWithFormat:@"invalid data or permissions for dir %@", path.stringByDeletingLastPathComponent])]; }
+        if (![data writeToFile:temporaryPath atomically:NO]) {
+            if (outerr) { *outerr = [NSString stringWithFormat:@"Error creating property file: invalid data or permissions for dir %@", path.stringByDeletingLastPathComponent]; }
             
         // Move/copy temporary file to final location
         } else {
@@ -227,8 +318,68 @@
         }
     }];
     
+    if (result) [self setHash:hash forFile:path];
     return result;
 }
++ (NSMutableDictionary<NSString *, NSDictionary *> *)fileHashes
+{
+    static NSMutableDictionary *fileHashes = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        fileHashes = [NSMutableDictionary dictionary];
+    });
+    return fileHashes;
+}
++ (void)setHash:(uint64_t)hash forFile:(NSString *)path
+{
+    struct stat info;
+    NSMutableDictionary *fileHashes = self.fileHashes;
+    @synchronized(fileHashes) {
+        if (stat(path.fileSystemRepresentation, &info) != 0) {
+            [fileHashes removeObjectForKey:path];
+            return;
+        }
+        fileHashes[path] = @{
+            @"Hash": @(hash),
+            @"Size": @(info.st_size),
+            @"Modified": @(ModifiedTime(&info))
+        };
+    }
+}
++ (void)forgetHashForFile:(NSString *)path
+{
+    NSMutableDictionary *fileHashes = self.fileHashes;
+    @synchronized(fileHashes) {
+        [fileHashes removeObjectForKey:path];
+    }
+}
++ (BOOL)file:(NSString *)path hasHash:(uint64_t)hash length:(NSUInteger)length user:(PGUser *)user
+{
+    // Must be a file of the same size, with the right owner
+    struct stat info;
+    if (stat(path.fileSystemRepresentation, &info) != 0) return NO;
+    if (!S_ISREG(info.st_mode) || (unsigned long long)info.st_size != length) return NO;
+    if ((NSInteger)info.st_uid != (user ?: PGUser.current).uid) return NO;
+    
+    // Same as last written - no need to read it
+    NSDictionary *written;
+    NSMutableDictionary *fileHashes = self.fileHashes;
+    @synchronized(fileHashes) {
+        written = fileHashes[path];
+    }
+    long long modified = ModifiedTime(&info);
+    if (written &&
+        [written[@"Size"] longLongValue] == info.st_size &&
+        [written[@"Modified"] longLongValue] == modified) {
+        return [written[@"Hash"] unsignedLongLongValue] == hash;
+    }
+    
+    // Otherwise hash the file - daemon files are small
+    NSData *existing = [NSData dataWithContentsOfFile:path];
+    if (existing.length != length || HashData(existing) != hash) return NO;
+    [self setHash:hash forFile:path];
+    return YES;
+}
 + (void)temporaryFileWithExtension:(NSString *)extension usingBlock:(void(^)(NSString *temporaryPath))block
 {
     // Note that the preferred method for getting a temporary directory
@@ -245,7 +396,7 @@
     block(path);
     NSString *error = nil;
     [self remove:path error:&error];
-    if (IsLogging) { if (error) { DLog(error); } }
+    if (IsLogging) { if (error) { DLog(@"%@", error); } }
 }
 
 + (BOOL)remove:(NSString *)path error:(NSString *__autoreleasing *)error
@@ -289,6 +440,7 @@
         }
     }
     
+    if (result) [self forgetHashForFile:path];
     return result;
 }
 
@@ -330,6 +482,7 @@
         }
     }
     
+    if (result && move) [self forgetHashForFile:from];
     return result;
 }
 
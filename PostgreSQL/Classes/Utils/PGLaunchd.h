@@ -29,6 +29,24 @@
 #import "PGProcess.h"
 #import "PGRights.h"
 
+#pragma mark - PGLaunchdBackend
+
+/**
+ * Replaces launchd, e.g. with an in-memory fake so the server controller can be exercised
+ * without loading real jobs.
+ *
+ * Methods are called on any thread, so implementations must be thread-safe.
+ */
+@protocol PGLaunchdBackend <NSObject>
+- (NSArray *)loadedDaemonsWithNameLike:(NSString *)pattern forRootUser:(BOOL)root;
+- (NSDictionary *)loadedDaemonWithName:(NSString *)name forRootUser:(BOOL)root;
+- (BOOL)startDaemonWithFile:(NSString *)file forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+- (BOOL)restartDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+- (BOOL)stopDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+@end
+
+
+
 #pragma mark - PGLaunchd
 /**
  * Utility class for looking up and starting/stopping daemons in launchd
@@ -40,6 +58,11 @@
  */
 @property (class, nonatomic, readonly) PGRights *rights;
 
+/**
+ * If set, all daemon lookups and changes use the backend instead of launchd.
+ */
+@property (class, nonatomic, strong) id<PGLaunchdBackend> backend;
+
 /**
  * Gets list of daemon names loaded in root user's or current user's launchd
  */
@@ -55,6 +78,13 @@
  */
 + (BOOL)startDaemonWithFile:(NSString *)file forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
 
+/**
+ * Starts the named daemon that is already loaded in launchd but not running. Does nothing if it
+ * is running, as killing it would be launchd's smart shutdown - stop it properly first instead.
+ * Much cheaper than unloading and reloading, but the loaded job's settings are unchanged.
+ */
++ (BOOL)restartDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+
 /**
  * Unloads the named daemon from launchd.
  *
@@ -25,14 +25,27 @@
 //
 
 #import "PGLaunchd.h"
+#ifdef __APPLE__
 #import <ServiceManagement/ServiceManagement.h>
+#endif
 
 #pragma mark - PGLaunchd
 
 @implementation PGLaunchd
 
+static id<PGLaunchdBackend> Backend;
+
 #pragma mark Main Methods
 
++ (id<PGLaunchdBackend>)backend
+{
+    @synchronized(self) { return Backend; }
+}
++ (void)setBackend:(id<PGLaunchdBackend>)backend
+{
+    @synchronized(self) { Backend = backend; }
+}
+
 + (PGRights *)rights
 {
     static PGRights *rights;
@@ -60,6 +73,10 @@
 {
     pattern = TrimToNil(pattern);
     
+    id<PGLaunchdBackend> backend = self.backend;
+    if (backend) return [backend loadedDaemonsWithNameLike:pattern forRootUser:root];
+    
+#ifdef __APPLE__
     CFStringRef domain = root ? kSMDomainSystemLaunchd : kSMDomainUserLaunchd;
     #pragma clang diagnostic push
     #pragma clang diagnostic ignored "-Wdeprecated-declarations"
@@ -68,6 +85,10 @@
     if (allJobs.count == 0) return nil;
     
     return pattern ? [allJobs filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"Label LIKE[cd] %@", pattern]] : allJobs;
+#else
+    // No launchd - only a backend has daemons
+    return nil;
+#endif
 }
 
 + (NSDictionary *)loadedDaemonWithName:(NSString *)name forRootUser:(BOOL)root
@@ -75,11 +96,18 @@
     name = TrimToNil(name);
     if (!name) return nil;
     
+    id<PGLaunchdBackend> backend = self.backend;
+    if (backend) return [backend loadedDaemonWithName:name forRootUser:root];
+    
+#ifdef __APPLE__
     CFStringRef domain = root ? kSMDomainSystemLaunchd : kSMDomainUserLaunchd;
     #pragma clang diagnostic push
     #pragma clang diagnostic ignored "-Wdeprecated-declarations"
     return CFBridgingRelease(SMJobCopyDictionary(domain, (__bridge CFStringRef)(name)));
     #pragma clang diagnostic pop
+#else
+    return nil;
+#endif
 }
 
 + (BOOL)startDaemonWithFile:(NSString *)file forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
@@ -89,6 +117,9 @@
     
     file = [file stringByExpandingTildeInPath];
     
+    id<PGLaunchdBackend> backend = self.backend;
+    if (backend) return [backend startDaemonWithFile:file forRootUser:root auth:auth error:error];
+    
     // Invalid file
     if (![PGFile fileExists:file]) {
         if (error) *error = [NSString stringWithFormat:@"Not a valid daemon property file: %@", file];
@@ -98,8 +129,27 @@
     // Get Domain
     NSString *domain = root ? @"system" : [NSString stringWithFormat:@"gui/%@", @(PGUser.current.uid)];
 
+    // Execute - system daemons must be owned by root, so a file written by the user is
+    // handed over in the same privileged command rather than a separate move
+    NSString *command = root ?
+        [NSString stringWithFormat:@"chown root:wheel \"%1$@\" && chmod 644 \"%1$@\" && launchctl bootstrap %2$@ \"%1$@\"", file, domain] :
+        [NSString stringWithFormat:@"launchctl bootstrap %@ \"%@\"", domain, file];
+    return [PGProcess runShellCommand:command forRootUser:root auth:auth error:error];
+}
+
++ (BOOL)restartDaemonWithName:(NSString *)name forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error
+{
+    name = TrimToNil(name);
+    if (!name) return NO;
+    
+    id<PGLaunchdBackend> backend = self.backend;
+    if (backend) return [backend restartDaemonWithName:name forRootUser:root auth:auth error:error];
+    
+    // Get Domain
+    NSString *domain = root ? @"system" : [NSString stringWithFormat:@"gui/%@", @(PGUser.current.uid)];
+    
     // Execute
-    NSString *command = [NSString stringWithFormat:@"launchctl bootstrap %@ \"%@\"", domain, file];
+    NSString *command = [NSString stringWithFormat:@"launchctl kickstart \"%@/%@\"", domain, name];
     return [PGProcess runShellCommand:command forRootUser:root auth:auth error:error];
 }
 
@@ -108,6 +158,9 @@
     name = TrimToNil(name);
     if (!name) return NO;
     
+    id<PGLaunchdBackend> backend = self.backend;
+    if (backend) return [backend stopDaemonWithName:name forRootUser:root auth:auth error:error];
+    
     // Silently ignore if daemon not loaded
     if (![self loadedDaemonWithName:name forRootUser:root]) return YES;
     
@@ -0,0 +1,145 @@
+//
+//  PGLogFile.h
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class PGLogFile;
+
+#pragma mark - Constants
+
+/**
+ * Severity of a PostgreSQL log line, in increasing order of importance.
+ *
+ * Continuation lines (DETAIL, HINT, STATEMENT etc) take the severity of the line they follow.
+ */
+typedef NS_ENUM(uint8_t, PGLogSeverity) {
+    PGLogSeverityNone = 0,
+    PGLogSeverityDebug,
+    PGLogSeverityInfo,
+    PGLogSeverityNotice,
+    PGLogSeverityLog,
+    PGLogSeverityWarning,
+    PGLogSeverityError,
+    PGLogSeverityFatal,
+    PGLogSeverityPanic
+};
+
+#pragma mark - PGLogFileDelegate
+
+/**
+ * Notified when lines are added to the log file.
+ */
+@protocol PGLogFileDelegate <NSObject>
+/// Called on main thread. Also called if the file was truncated or replaced, in which case
+/// the line count may go down.
+- (void)logFile:(PGLogFile *)logFile didChangeLineCount:(NSUInteger)lineCount;
+@end
+
+
+
+#pragma mark - PGLogFile
+
+/**
+ * A read-only view of a (potentially multi-GB) log file, with random access by line.
+ *
+ * The start offset of every line is indexed on a background queue, and lines appended
+ * to the file are indexed as they are written. Lines are only read and decoded when
+ * asked for, so the cost of viewing a log is independent of its size.
+ *
+ * If the file is truncated or replaced (e.g. by log rotation) it is re-indexed from the start.
+ *
+ * The severity and timestamp of each line is indexed too, and the whole index is saved to a
+ * sidecar cache file, so re-opening a log only indexes lines added since it was last opened.
+ * Lines can be filtered by severity and time without reading the log itself.
+ */
+@interface PGLogFile : NSObject
+
+@property (nonatomic, strong, readonly) NSString *path;
+@property (nonatomic, weak) id<PGLogFileDelegate> delegate;
+
+/// Number of lines indexed so far. Includes last line even if it has no newline yet.
+@property (readonly) NSUInteger lineCount;
+
+/// If YES, the whole file has been indexed at least once
+@property (readonly) BOOL indexed;
+
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ * Finds the most recent messages with at least the specified severity, by reading backwards
+ * from the end of the file in fixed-size blocks. Continuation lines (DETAIL, HINT etc) are
+ * included with their message, and the timestamp prefix is removed.
+ *
+ * Does not need the file to be indexed, so is fast even for a huge log.
+ *
+ * @param maxCount stop once this many messages are found
+ * @param maxBytes stop after reading this many bytes, or 0 for no limit
+ * @return messages, oldest first, or nil if the file cannot be read
+ */
++ (NSArray<NSString *> *)lastMessagesInFile:(NSString *)path severity:(PGLogSeverity)severity maxCount:(NSUInteger)maxCount maxBytes:(unsigned long long)maxBytes;
+
+/**
+ * Starts indexing in the background, and following the file for changes.
+ */
+- (void)open;
+
+/**
+ * Stops following the file for changes, and releases the file.
+ */
+- (void)close;
+
+/**
+ * @return the line, without line terminator, or nil if index is beyond the lines indexed so far
+ */
+- (NSString *)lineAtIndex:(NSUInteger)index;
+
+/**
+ * @return the severity of the line, or PGLogSeverityNone if unknown or not yet indexed
+ */
+- (PGLogSeverity)severityOfLineAtIndex:(NSUInteger)index;
+
+/**
+ * Finds the lines logged within the time range, using binary search of the time index.
+ *
+ * Note that log times are compared as wall-clock times in the current time zone, because
+ * PostgreSQL's log timestamps are in the server's log_timezone, normally the system zone.
+ *
+ * @param from start of time range, or nil for the first line
+ * @param to end of time range (exclusive), or nil for the last line
+ * @return range of lines
+ */
+- (NSRange)linesFrom:(NSDate *)from to:(NSDate *)to;
+
+/**
+ * Finds the lines with at least the specified severity. Uses per-severity lists of line
+ * numbers, so only the matching lines are visited.
+ *
+ * @param severity minimum severity, must be at least PGLogSeverityWarning
+ * @param range only include lines in this range
+ */
+- (NSIndexSet *)linesWithSeverity:(PGLogSeverity)severity inRange:(NSRange)range;
+
+@end
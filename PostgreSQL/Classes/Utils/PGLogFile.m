@@ -0,0 +1,823 @@
+//
+//  PGLogFile.m
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "PGLogFile.h"
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+/// Amount read at a time when indexing
+#define PGLogFileIndexChunkSize (4 * 1024 * 1024)
+/// Lines longer than this are truncated
+#define PGLogFileMaxLineLength (16 * 1024)
+/// Bytes at start of line searched for timestamp and severity
+#define PGLogFilePrefixLength 128
+/// Minimum time between delegate notifications while indexing
+#define PGLogFileNotifyInterval 0.1
+/// How often to check if a deleted log file has been recreated
+#define PGLogFileReopenInterval 1.0
+/// Block size when reading backwards from the end of the file
+#define PGLogFileReverseBlockSize (64 * 1024)
+/// Increment if the sidecar index format changes
+#define PGLogFileIndexVersion 2
+/// Bytes hashed at the start of the log, and just before the indexed length, to check the index is still valid
+#define PGLogFileFingerprintLength 4096
+/// Severities with their own list of line numbers
+#define PGLogFilePostingsCount (PGLogSeverityPanic - PGLogSeverityWarning + 1)
+
+#pragma mark - Constants / Functions
+
+/**
+ * Hash of the bytes at the start of the file and just before length. Copy-truncate rotation
+ * keeps the inode, so this detects a log that was truncated and has grown again since indexing.
+ *
+ * @return The hash, or 0 if the bytes can't be read
+ */
+static uint64_t
+LogFingerprint(int fd, unsigned long long length)
+{
+    char buffer[PGLogFileFingerprintLength];
+    uint64_t hash = 14695981039346656037ULL;
+    unsigned long long offsets[2] = { 0, length > PGLogFileFingerprintLength ? length - PGLogFileFingerprintLength : 0 };
+    for (int i = 0; i < 2; i++) {
+        size_t wanted = (size_t)MIN(length - offsets[i], (unsigned long long)PGLogFileFingerprintLength);
+        if (pread(fd, buffer, wanted, (off_t)offsets[i]) != (ssize_t)wanted) return 0;
+        for (size_t j = 0; j < wanted; j++) {
+            hash ^= (uint8_t)buffer[j];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+/// Reads exactly length bytes of the file into data, without an intermediate copy
+static BOOL
+ReadIndexFile(NSString *path, NSMutableData *data, NSUInteger length)
+{
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if (fd < 0) return NO;
+    data.length = length;
+    NSUInteger total = 0;
+    while (total < length) {
+        ssize_t bytesRead = read(fd, (char *)data.mutableBytes + total, length - total);
+        if (bytesRead <= 0) break;
+        total += (NSUInteger)bytesRead;
+    }
+    close(fd);
+    return total == length;
+}
+
+static inline BOOL
+ParseDigits(const char *bytes, int count, int *value)
+{
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (bytes[i] < '0' || bytes[i] > '9') return NO;
+        result = result * 10 + (bytes[i] - '0');
+    }
+    *value = result;
+    return YES;
+}
+
+/// Parses "YYYY-MM-DD HH:MM:SS" at start of line, as seconds since 1970 (wall-clock, no time zone).
+/// Returns 0 if not found.
+static uint32_t
+ParseLogTime(const char *bytes, size_t length)
+{
+    int year, month, day, hour, minute, second;
+    if (length < 19 ||
+        !ParseDigits(bytes, 4, &year) || bytes[4] != '-' ||
+        !ParseDigits(bytes+5, 2, &month) || bytes[7] != '-' ||
+        !ParseDigits(bytes+8, 2, &day) || (bytes[10] != ' ' && bytes[10] != 'T') ||
+        !ParseDigits(bytes+11, 2, &hour) || bytes[13] != ':' ||
+        !ParseDigits(bytes+14, 2, &minute) || bytes[16] != ':' ||
+        !ParseDigits(bytes+17, 2, &second)) return 0;
+    if (month < 1 || month > 12 || day < 1 || day > 31) return 0;
+    
+    // Days since 1970 from civil date, without calling into libc
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long days = era * 146097 + dayOfEra - 719468;
+    
+    long long seconds = days * 86400LL + hour * 3600 + minute * 60 + second;
+    return seconds > 0 && seconds < UINT32_MAX ? (uint32_t)seconds : 0;
+}
+
+/// Finds the first "SEVERITY:" word in the line prefix, and optionally its offset.
+/// Sets continuation if the line belongs to the previous message (e.g. DETAIL:, or starts with tab).
+static PGLogSeverity
+ParseLogSeverity(const char *bytes, size_t length, BOOL *continuation, size_t *offset)
+{
+    static const struct { const char *word; PGLogSeverity severity; BOOL continuation; } Words[] = {
+        { "PANIC", PGLogSeverityPanic, NO },
+        { "FATAL", PGLogSeverityFatal, NO },
+        { "ERROR", PGLogSeverityError, NO },
+        { "WARNING", PGLogSeverityWarning, NO },
+        { "LOG", PGLogSeverityLog, NO },
+        { "NOTICE", PGLogSeverityNotice, NO },
+        { "INFO", PGLogSeverityInfo, NO },
+        { "DEBUG", PGLogSeverityDebug, NO },
+        { "DEBUG1", PGLogSeverityDebug, NO },
+        { "DEBUG2", PGLogSeverityDebug, NO },
+        { "DEBUG3", PGLogSeverityDebug, NO },
+        { "DEBUG4", PGLogSeverityDebug, NO },
+        { "DEBUG5", PGLogSeverityDebug, NO },
+        { "DETAIL", PGLogSeverityNone, YES },
+        { "HINT", PGLogSeverityNone, YES },
+        { "STATEMENT", PGLogSeverityNone, YES },
+        { "CONTEXT", PGLogSeverityNone, YES },
+        { "QUERY", PGLogSeverityNone, YES },
+        { "LOCATION", PGLogSeverityNone, YES },
+    };
+    
+    *continuation = length > 0 && bytes[0] == '\t';
+    if (*continuation) return PGLogSeverityNone;
+    
+    for (size_t i = 0; i < length; i++) {
+        // Word must start at beginning of line or after a space
+        if (bytes[i] < 'A' || bytes[i] > 'Z') continue;
+        if (i > 0 && bytes[i-1] != ' ') continue;
+        
+        size_t end = i;
+        while (end < length && ((bytes[end] >= 'A' && bytes[end] <= 'Z') || (bytes[end] >= '0' && bytes[end] <= '9'))) end++;
+        if (end >= length || bytes[end] != ':') { i = end; continue; }
+        
+        size_t wordLength = end - i;
+        for (size_t w = 0; w < sizeof(Words) / sizeof(Words[0]); w++) {
+            if (strlen(Words[w].word) != wordLength) continue;
+            if (strncmp(Words[w].word, bytes + i, wordLength) != 0) continue;
+            *continuation = Words[w].continuation;
+            if (offset) *offset = i;
+            return Words[w].severity;
+        }
+        i = end;
+    }
+    return PGLogSeverityNone;
+}
+
+
+
+#pragma mark - Interfaces
+
+@interface PGLogFile ()
+
+/// Serial queue for indexing and file events
+@property (nonatomic, strong) dispatch_queue_t queue;
+/// Watches the file for writes, deletes and renames
+@property (nonatomic, strong) dispatch_source_t source;
+/// If NO, stop indexing and watching
+@property (atomic) BOOL following;
+/// If YES, delegate notification is already scheduled
+@property (nonatomic) BOOL notifying;
+@property (readwrite) BOOL indexed;
+/// Base path of the sidecar index files in the caches dir
+@property (nonatomic, strong, readonly) NSString *indexPath;
+
+/**
+ * (Re)opens the file at path, and re-indexes from the start if it is a different file.
+ */
+- (void)reopen;
+
+/**
+ * Indexes any bytes appended since last indexed.
+ */
+- (void)indexAppended;
+
+/**
+ * Clears the index. Must be called holding lock.
+ */
+- (void)resetIndex;
+
+/**
+ * Number of lines. Must be called holding lock.
+ */
+- (NSUInteger)lineCountHoldingLock;
+
+/**
+ * Loads the sidecar index, if it is for the same file. Must be called holding lock.
+ */
+- (BOOL)loadIndexForInode:(ino_t)inode size:(unsigned long long)size;
+
+/**
+ * Appends lines indexed since last saved to the sidecar index.
+ */
+- (void)saveIndex;
+
+/**
+ * Deletes the sidecar index, e.g. because the log was truncated.
+ */
+- (void)deleteIndex;
+
+@end
+
+
+
+#pragma mark - PGLogFile
+
+@implementation PGLogFile
+{
+    // Guarded by @synchronized(self)
+    int _fd;
+    ino_t _inode;
+    unsigned long long _length;
+    /// Start offset of each line (unsigned long long), plus start of the next line
+    NSMutableData *_starts;
+    /// Time of each complete line (uint32_t), inherited from previous line if none
+    NSMutableData *_times;
+    /// Severity of each complete line (PGLogSeverity)
+    NSMutableData *_severities;
+    /// Line numbers (uint32_t) of each severity from Warning to Panic
+    NSMutableData *_postings[PGLogFilePostingsCount];
+    
+    // Only accessed on queue
+    NSUInteger _savedLines;
+}
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    self = [super init];
+    if (self) {
+        _path = [path stringByExpandingTildeInPath];
+        _fd = -1;
+        _starts = [NSMutableData data];
+        _times = [NSMutableData data];
+        _severities = [NSMutableData data];
+        for (int i = 0; i < PGLogFilePostingsCount; i++) _postings[i] = [NSMutableData data];
+        [self resetIndex];
+        
+        NSString *indexName = [[_path stringByStandardizingPath] stringByReplacingOccurrencesOfString:@"/" withString:@"_"];
+        _indexPath = [[PGLogFileIndexDir stringByExpandingTildeInPath] stringByAppendingPathComponent:indexName];
+        
+        NSString *label = [NSString stringWithFormat:@"%@.log.%@", PGPrefsAppID, _path.lastPathComponent];
+        _queue = dispatch_queue_create(label.UTF8String, DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+- (void)dealloc
+{
+    if (_source) dispatch_source_cancel(_source);
+    if (_fd >= 0) close(_fd);
+}
+- (void)open
+{
+    self.following = YES;
+    dispatch_async(self.queue, ^{
+        [self reopen];
+    });
+}
+- (void)close
+{
+    self.following = NO;
+    dispatch_async(self.queue, ^{
+        [self stopWatching];
+        @synchronized(self) {
+            if (self->_fd >= 0) close(self->_fd);
+            self->_fd = -1;
+        }
+    });
+}
+
+
+
+#pragma mark Messages
+
++ (NSArray<NSString *> *)lastMessagesInFile:(NSString *)path severity:(PGLogSeverity)severity maxCount:(NSUInteger)maxCount maxBytes:(unsigned long long)maxBytes
+{
+    path = [path stringByExpandingTildeInPath];
+    if (!NonBlank(path) || maxCount == 0) return nil;
+    
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) close(fd);
+        return nil;
+    }
+    
+    // Found newest first
+    NSMutableArray<NSString *> *messages = [NSMutableArray array];
+    NSMutableArray<NSString *> *continuations = [NSMutableArray array];
+    BOOL (^AddLine)(const char *, size_t) = ^BOOL(const char *bytes, size_t length) {
+        if (length > 0 && bytes[length - 1] == '\r') length--;
+        if (length == 0) return NO;
+        
+        BOOL continuation = NO;
+        size_t offset = 0;
+        PGLogSeverity lineSeverity = ParseLogSeverity(bytes, MIN(length, (size_t)PGLogFilePrefixLength), &continuation, &offset);
+        
+        // Skip timestamp and pid prefix, e.g. "2026-10-18 09:30:00 BST [123] FATAL:  ..."
+        NSData *data = [NSData dataWithBytesNoCopy:(void *)(bytes + offset) length:MIN(length - offset, (size_t)PGLogFileMaxLineLength) freeWhenDone:NO];
+        NSString *line = TrimToNil([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?:
+                                   [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding]);
+        
+        // DETAIL, HINT etc - only know which message it belongs to once the message is found
+        if (continuation) {
+            if (line) [continuations insertObject:line atIndex:0];
+            return NO;
+        }
+        if (lineSeverity >= severity && line) {
+            [continuations insertObject:line atIndex:0];
+            [messages addObject:[continuations componentsJoinedByString:@"\n"]];
+        }
+        [continuations removeAllObjects];
+        return messages.count >= maxCount;
+    };
+    
+    // Read backwards a block at a time, carrying any partial line into the previous block
+    unsigned long long end = (unsigned long long)info.st_size;
+    unsigned long long limit = maxBytes > 0 && maxBytes < end ? end - maxBytes : 0;
+    NSMutableData *carry = [NSMutableData data];
+    BOOL stop = NO;
+    while (!stop && end > limit) {
+        size_t blockSize = (size_t)MIN(end - limit, (unsigned long long)PGLogFileReverseBlockSize);
+        unsigned long long start = end - blockSize;
+        NSMutableData *block = [NSMutableData dataWithLength:blockSize];
+        if (pread(fd, block.mutableBytes, blockSize, (off_t)start) != (ssize_t)blockSize) break;
+        [block appendData:carry];
+        
+        const char *bytes = block.bytes;
+        size_t lineEnd = block.length;
+        for (size_t i = block.length; i > 0 && !stop; i--) {
+            if (bytes[i - 1] != '\n') continue;
+            stop = AddLine(bytes + i, lineEnd - i);
+            lineEnd = i - 1;
+        }
+        
+        // First line of file is complete, otherwise it continues in the previous block
+        if (!stop && start == 0) stop = AddLine(bytes, lineEnd);
+        if (lineEnd > PGLogFileMaxLineLength) lineEnd = 0;
+        carry = [NSMutableData dataWithBytes:bytes length:lineEnd];
+        end = start;
+    }
+    close(fd);
+    
+    return [[messages reverseObjectEnumerator] allObjects];
+}
+
+
+
+#pragma mark Lines
+
+- (NSUInteger)lineCount
+{
+    @synchronized(self) {
+        return [self lineCountHoldingLock];
+    }
+}
+- (NSUInteger)lineCountHoldingLock
+{
+    NSUInteger count = _starts.length / sizeof(unsigned long long);
+    if (count == 0) return 0;
+    
+    // Last start is after the final newline, so only a line if something follows it
+    unsigned long long lastStart = ((const unsigned long long *)_starts.bytes)[count - 1];
+    return lastStart < _length ? count : count - 1;
+}
+- (NSString *)lineAtIndex:(NSUInteger)index
+{
+    NSMutableData *data = nil;
+    @synchronized(self) {
+        if (_fd < 0 || index >= [self lineCountHoldingLock]) return nil;
+        
+        const unsigned long long *starts = _starts.bytes;
+        NSUInteger count = _starts.length / sizeof(unsigned long long);
+        unsigned long long start = starts[index];
+        unsigned long long end = index + 1 < count ? starts[index + 1] - 1 : _length;
+        size_t length = (size_t)MIN(end - start, (unsigned long long)PGLogFileMaxLineLength);
+        
+        // Note: short read is possible if file truncated since indexed
+        data = [NSMutableData dataWithLength:length];
+        ssize_t bytesRead = pread(_fd, data.mutableBytes, length, (off_t)start);
+        if (bytesRead < 0) return nil;
+        data.length = (NSUInteger)bytesRead;
+    }
+    
+    // Strip carriage return
+    if (data.length > 0 && ((const char *)data.bytes)[data.length - 1] == '\r') data.length--;
+    
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?:
+           [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding];
+}
+- (PGLogSeverity)severityOfLineAtIndex:(NSUInteger)index
+{
+    @synchronized(self) {
+        if (index >= _severities.length) return PGLogSeverityNone;
+        return ((const PGLogSeverity *)_severities.bytes)[index];
+    }
+}
+
+
+
+#pragma mark Filters
+
+- (NSRange)linesFrom:(NSDate *)from to:(NSDate *)to
+{
+    // Convert to wall-clock seconds, same as parsed log times
+    uint32_t (^WallClock)(NSDate *) = ^uint32_t(NSDate *date) {
+        double seconds = date.timeIntervalSince1970 + [NSTimeZone.localTimeZone secondsFromGMTForDate:date];
+        return (uint32_t)MAX(0, MIN(seconds, (double)UINT32_MAX));
+    };
+    
+    @synchronized(self) {
+        const uint32_t *times = _times.bytes;
+        NSUInteger count = _times.length / sizeof(uint32_t);
+        NSUInteger lineCount = [self lineCountHoldingLock];
+        
+        // First line with time >= value (times are in log order, so non-decreasing)
+        NSUInteger (^LowerBound)(uint32_t) = ^NSUInteger(uint32_t value) {
+            NSUInteger low = 0, high = count;
+            while (low < high) {
+                NSUInteger mid = low + (high - low) / 2;
+                if (times[mid] < value) low = mid + 1;
+                else high = mid;
+            }
+            return low;
+        };
+        
+        NSUInteger first = from ? LowerBound(WallClock(from)) : 0;
+        
+        // Incomplete last line has no time yet, so include it if unbounded
+        NSUInteger last = to ? LowerBound(WallClock(to)) : lineCount;
+        if (last < first) last = first;
+        return NSMakeRange(first, last - first);
+    }
+}
+- (NSIndexSet *)linesWithSeverity:(PGLogSeverity)severity inRange:(NSRange)range
+{
+    NSMutableIndexSet *result = [NSMutableIndexSet indexSet];
+    if (range.length == 0) return result;
+    
+    @synchronized(self) {
+        for (PGLogSeverity s = MAX(severity, PGLogSeverityWarning); s <= PGLogSeverityPanic; s++) {
+            NSData *posting = _postings[s - PGLogSeverityWarning];
+            const uint32_t *lines = posting.bytes;
+            NSUInteger count = posting.length / sizeof(uint32_t);
+            
+            // Binary search for start of range
+            NSUInteger low = 0, high = count;
+            while (low < high) {
+                NSUInteger mid = low + (high - low) / 2;
+                if (lines[mid] < range.location) low = mid + 1;
+                else high = mid;
+            }
+            for (NSUInteger i = low; i < count && lines[i] < NSMaxRange(range); i++) {
+                [result addIndex:lines[i]];
+            }
+        }
+    }
+    return result;
+}
+
+
+
+#pragma mark Private
+
+- (void)resetIndex
+{
+    unsigned long long start = 0;
+    _starts.length = 0;
+    [_starts appendBytes:&start length:sizeof(start)];
+    _times.length = 0;
+    _severities.length = 0;
+    for (int i = 0; i < PGLogFilePostingsCount; i++) _postings[i].length = 0;
+    _length = 0;
+}
+- (void)reopen
+{
+    [self stopWatching];
+    if (!self.following) return;
+    
+    int fd = open(self.path.fileSystemRepresentation, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) close(fd);
+        
+        // Deleted - wait for it to be recreated
+        @synchronized(self) {
+            if (_fd >= 0) close(_fd);
+            _fd = -1;
+            _inode = 0;
+            [self resetIndex];
+        }
+        [self notifyDelegate];
+        
+        weakify(self);
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PGLogFileReopenInterval * NSEC_PER_SEC)), self.queue, ^{
+            strongify(self);
+            [self reopen];
+        });
+        return;
+    }
+    
+    BOOL replaced, loaded = NO;
+    @synchronized(self) {
+        replaced = info.st_ino != _inode;
+        if (_fd >= 0) close(_fd);
+        _fd = fd;
+        if (replaced) {
+            _inode = info.st_ino;
+            [self resetIndex];
+            
+            // Continue from the last saved index
+            loaded = [self loadIndexForInode:info.st_ino size:(unsigned long long)info.st_size];
+            if (!loaded) [self resetIndex];
+            _savedLines = _severities.length;
+        }
+    }
+    if (replaced && !loaded) [self deleteIndex];
+    if (replaced) [self notifyDelegate];
+    
+    [self startWatching];
+    [self indexAppended];
+}
+- (void)indexAppended
+{
+    int fd;
+    unsigned long long offset;
+    @synchronized(self) {
+        fd = _fd;
+        offset = _length;
+    }
+    if (fd < 0) return;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) return;
+    unsigned long long size = (unsigned long long)info.st_size;
+    
+    // Truncated, e.g. copy-truncate log rotation - start again
+    if (size < offset) {
+        @synchronized(self) {
+            [self resetIndex];
+        }
+        [self deleteIndex];
+        offset = 0;
+        [self notifyDelegate];
+    }
+    
+    // Continue from start of last (incomplete) line
+    unsigned long long lineStart;
+    uint32_t lastTime = 0;
+    PGLogSeverity lastSeverity = PGLogSeverityNone;
+    @synchronized(self) {
+        lineStart = ((const unsigned long long *)_starts.bytes)[_starts.length / sizeof(unsigned long long) - 1];
+        NSUInteger lines = _severities.length;
+        if (lines > 0) {
+            lastTime = ((const uint32_t *)_times.bytes)[lines - 1];
+            lastSeverity = ((const PGLogSeverity *)_severities.bytes)[lines - 1];
+        }
+    }
+    
+    char *buffer = malloc(PGLogFileIndexChunkSize);
+    if (!buffer) return;
+    
+    while (offset < size && self.following) {
+        ssize_t bytesRead = pread(fd, buffer, (size_t)MIN(size - offset, (unsigned long long)PGLogFileIndexChunkSize), (off_t)offset);
+        if (bytesRead <= 0) break;
+        
+        NSUInteger capacity = (NSUInteger)bytesRead / 64;
+        NSMutableData *starts = [NSMutableData dataWithCapacity:capacity * sizeof(unsigned long long)];
+        NSMutableData *times = [NSMutableData dataWithCapacity:capacity * sizeof(uint32_t)];
+        NSMutableData *severities = [NSMutableData dataWithCapacity:capacity];
+        
+        const char *end = buffer + bytesRead;
+        for (const char *p = buffer; (p = memchr(p, '\n', end - p)); p++) {
+            unsigned long long lineEnd = offset + (p - buffer);
+            
+            // Line prefix - only need to re-read if line started in a previous chunk
+            char prefix[PGLogFilePrefixLength];
+            const char *prefixBytes = prefix;
+            size_t prefixLength = (size_t)MIN(lineEnd - lineStart, (unsigned long long)PGLogFilePrefixLength);
+            if (lineStart >= offset) {
+                prefixBytes = buffer + (lineStart - offset);
+            } else {
+                ssize_t prefixRead = pread(fd, prefix, prefixLength, (off_t)lineStart);
+                prefixLength = prefixRead > 0 ? (size_t)prefixRead : 0;
+            }
+            
+            // Time & severity, inherited from previous line if none
+            uint32_t time = ParseLogTime(prefixBytes, prefixLength);
+            if (time) lastTime = time;
+            BOOL continuation = NO;
+            PGLogSeverity severity = ParseLogSeverity(prefixBytes, prefixLength, &continuation, NULL);
+            if (continuation) severity = lastSeverity;
+            lastSeverity = severity;
+            
+            unsigned long long nextStart = lineEnd + 1;
+            [starts appendBytes:&nextStart length:sizeof(nextStart)];
+            [times appendBytes:&lastTime length:sizeof(lastTime)];
+            [severities appendBytes:&severity length:sizeof(severity)];
+            lineStart = nextStart;
+        }
+        offset += bytesRead;
+        
+        // Lines become visible chunk by chunk
+        @synchronized(self) {
+            uint32_t line = (uint32_t)_severities.length;
+            const PGLogSeverity *added = severities.bytes;
+            for (NSUInteger i = 0; i < severities.length; i++, line++) {
+                if (added[i] < PGLogSeverityWarning) continue;
+                [_postings[added[i] - PGLogSeverityWarning] appendBytes:&line length:sizeof(line)];
+            }
+            [_starts appendData:starts];
+            [_times appendData:times];
+            [_severities appendData:severities];
+            _length = offset;
+        }
+        [self saveIndex];
+        [self notifyDelegate];
+    }
+    free(buffer);
+    
+    if (offset >= size && !self.indexed) {
+        self.indexed = YES;
+        [self notifyDelegate];
+    }
+}
+
+
+
+#pragma mark Sidecar Index
+
+- (BOOL)loadIndexForInode:(ino_t)inode size:(unsigned long long)size
+{
+    NSDictionary *header = [NSDictionary dictionaryWithContentsOfFile:[self.indexPath stringByAppendingPathExtension:@"plist"]];
+    if ([header[@"Version"] integerValue] != PGLogFileIndexVersion) return NO;
+    if ([header[@"Inode"] unsignedLongLongValue] != (unsigned long long)inode) return NO;
+    
+    unsigned long long length = [header[@"Length"] unsignedLongLongValue];
+    NSUInteger lines = [header[@"Lines"] unsignedIntegerValue];
+    if (length > size || lines == 0) return NO;
+    
+    // Same inode, but may have been truncated and rewritten since
+    uint64_t fingerprint = LogFingerprint(_fd, length);
+    if (fingerprint == 0 || [header[@"Fingerprint"] unsignedLongLongValue] != fingerprint) return NO;
+    
+    // Files may be longer than header if interrupted while saving - only read the saved lines
+    if (!ReadIndexFile([self.indexPath stringByAppendingPathExtension:@"starts"], _starts, lines * sizeof(unsigned long long)) ||
+        !ReadIndexFile([self.indexPath stringByAppendingPathExtension:@"times"], _times, lines * sizeof(uint32_t)) ||
+        !ReadIndexFile([self.indexPath stringByAppendingPathExtension:@"severities"], _severities, lines)) return NO;
+    [_starts appendBytes:&length length:sizeof(length)];
+    _length = length;
+    
+    // Postings are quicker to rebuild than to save
+    const PGLogSeverity *values = _severities.bytes;
+    for (uint32_t line = 0; line < lines; line++) {
+        if (values[line] < PGLogSeverityWarning) continue;
+        [_postings[values[line] - PGLogSeverityWarning] appendBytes:&line length:sizeof(line)];
+    }
+    
+    DLog(@"%@: loaded %@ lines from index", self.path.lastPathComponent, @(lines));
+    return YES;
+}
+- (void)saveIndex
+{
+    NSData *starts, *times, *severities;
+    NSUInteger lines;
+    unsigned long long length;
+    ino_t inode;
+    int fd;
+    @synchronized(self) {
+        lines = _severities.length;
+        if (lines <= _savedLines) return;
+        
+        // Starts of complete lines only - last start is re-read on load
+        starts = [_starts subdataWithRange:NSMakeRange(_savedLines * sizeof(unsigned long long), (lines - _savedLines) * sizeof(unsigned long long))];
+        times = [_times subdataWithRange:NSMakeRange(_savedLines * sizeof(uint32_t), (lines - _savedLines) * sizeof(uint32_t))];
+        severities = [_severities subdataWithRange:NSMakeRange(_savedLines, lines - _savedLines)];
+        length = ((const unsigned long long *)_starts.bytes)[lines];
+        inode = _inode;
+        fd = _fd;
+    }
+    uint64_t fingerprint = fd >= 0 ? LogFingerprint(fd, length) : 0;
+    if (fingerprint == 0) return;
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    [fileManager createDirectoryAtPath:[self.indexPath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    // Append, overwriting anything after the last saved line
+    BOOL (^Append)(NSString *, NSData *, unsigned long long) = ^BOOL(NSString *extension, NSData *data, unsigned long long offset) {
+        NSString *path = [self.indexPath stringByAppendingPathExtension:extension];
+        if (offset == 0) [fileManager createFileAtPath:path contents:nil attributes:nil];
+        NSFileHandle *file = [NSFileHandle fileHandleForWritingAtPath:path];
+        if (!file) return NO;
+        [file truncateFileAtOffset:offset];
+        [file writeData:data];
+        [file closeFile];
+        return YES;
+    };
+    if (!Append(@"starts", starts, _savedLines * sizeof(unsigned long long)) ||
+        !Append(@"times", times, _savedLines * sizeof(uint32_t)) ||
+        !Append(@"severities", severities, _savedLines)) return;
+    
+    // Header written last, so a partial save is ignored
+    NSDictionary *header = @{
+        @"Version": @(PGLogFileIndexVersion),
+        @"Inode": @((unsigned long long)inode),
+        @"Length": @(length),
+        @"Lines": @(lines),
+        @"Fingerprint": @(fingerprint)
+    };
+    [header writeToFile:[self.indexPath stringByAppendingPathExtension:@"plist"] atomically:YES];
+    _savedLines = lines;
+}
+- (void)deleteIndex
+{
+    _savedLines = 0;
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    for (NSString *extension in @[@"plist", @"starts", @"times", @"severities"]) {
+        [fileManager removeItemAtPath:[self.indexPath stringByAppendingPathExtension:extension] error:nil];
+    }
+}
+
+
+
+#pragma mark File Events
+
+- (void)startWatching
+{
+#ifdef __APPLE__
+    int fd = open(self.path.fileSystemRepresentation, O_EVTONLY);
+    if (fd < 0) return;
+    
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_VNODE, fd, DISPATCH_VNODE_WRITE | DISPATCH_VNODE_EXTEND | DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME | DISPATCH_VNODE_REVOKE, self.queue);
+    if (!source) {
+        close(fd);
+        return;
+    }
+    
+    weakify(self);
+    dispatch_source_set_event_handler(source, ^{
+        strongify(self);
+        if (!self.source) return;
+        
+        // Replaced, e.g. log rotation by rename
+        unsigned long flags = dispatch_source_get_data(self.source);
+        if (flags & (DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME | DISPATCH_VNODE_REVOKE)) {
+            [self reopen];
+            
+        // Appended
+        } else {
+            [self indexAppended];
+        }
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+        close(fd);
+    });
+    self.source = source;
+    dispatch_resume(source);
+#else
+    // No vnode sources without kqueue - the file is only indexed when opened
+#endif
+}
+- (void)stopWatching
+{
+    if (!self.source) return;
+    dispatch_source_cancel(self.source);
+    self.source = nil;
+}
+- (void)notifyDelegate
+{
+    @synchronized(self) {
+        if (self.notifying) return;
+        self.notifying = YES;
+    }
+    
+    weakify(self);
+    MainThreadAfterDelay(PGLogFileNotifyInterval, ^{
+        strongify(self);
+        if (!self) return;
+        @synchronized(self) {
+            self.notifying = NO;
+        }
+        [self.delegate logFile:self didChangeLineCount:self.lineCount];
+    });
+}
+
+@end
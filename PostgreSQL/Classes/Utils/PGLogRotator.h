@@ -0,0 +1,90 @@
+//
+//  PGLogRotator.h
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#pragma mark - Constants
+
+/**
+ * When to rotate a log, and how many old segments to keep. Zero means no limit.
+ */
+typedef struct {
+    /// Rotate when the log is at least this many bytes
+    unsigned long long maxSize;
+    /// Rotate when the log was started at least this many seconds ago
+    NSTimeInterval maxAge;
+    /// Delete oldest segments until the log plus segments fit in this many bytes
+    unsigned long long maxTotalSize;
+} PGLogRotationPolicy;
+
+static inline PGLogRotationPolicy
+PGLogRotationPolicyMake(unsigned long long maxSize, NSTimeInterval maxAge, unsigned long long maxTotalSize)
+{
+    PGLogRotationPolicy policy = { maxSize, maxAge, maxTotalSize };
+    return policy;
+}
+
+
+
+#pragma mark - PGLogRotator
+
+/**
+ * Rotates log files that are held open by another process, e.g. a server's launchd
+ * StandardOutPath, which launchd opens once in append mode and never reopens.
+ *
+ * Uses copy-truncate: the log is copied to a timestamped segment next to it, e.g.
+ * server.20261018-093000.log, then truncated in place. Because the writer appends,
+ * it carries on at the new end of file. Any lines written between the final copy and
+ * the truncate are lost, so the copy is repeated until it catches up before truncating.
+ *
+ * Segments are compressed with gzip one at a time in the background, and the oldest
+ * are deleted once the total exceeds the policy's limit.
+ */
+@interface PGLogRotator : NSObject
+
+/**
+ * Rotates the log if it has exceeded the policy's size or age, then prunes old segments.
+ * Only logs writable without authorization are rotated.
+ *
+ * Safe to call from any thread. Each log has its own queue, so this blocks while copying
+ * this log, but never for other logs, and never while compressing or pruning.
+ *
+ * @return YES if the log was rotated
+ */
+- (BOOL)rotateLog:(NSString *)path policy:(PGLogRotationPolicy)policy error:(NSString **)error;
+
+/**
+ * @return NO if the log was found not to be writable without authorization, e.g. the log of a
+ * server started at boot, so is never rotated
+ */
+- (BOOL)canRotateLog:(NSString *)path;
+
+/**
+ * @return paths of all rotated segments of the log, newest first
+ */
+- (NSArray<NSString *> *)segmentsOfLog:(NSString *)path;
+
+@end
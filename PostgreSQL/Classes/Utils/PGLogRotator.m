@@ -0,0 +1,336 @@
+//
+//  PGLogRotator.m
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 18/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "PGLogRotator.h"
+#import "PGProcess.h"
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+/// Amount copied at a time when rotating
+#define PGLogRotatorCopyChunkSize (1024 * 1024)
+/// Format of the timestamp in segment file names
+#define PGLogRotatorSegmentDateFormat @"yyyyMMdd-HHmmss"
+/// Length of the timestamp in segment file names
+#define PGLogRotatorSegmentDateLength 15
+/// Compression tool, always present on macOS
+#define PGLogRotatorGzip @"/usr/bin/gzip"
+
+#pragma mark - Interfaces
+
+/**
+ * State of a single log, so each poll only needs one stat() unless the log is due for rotation.
+ */
+@interface PGRotatedLog : NSObject
+/// Serialises rotation and pruning of this log only, so a slow copy never holds up other logs
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+/// Identity of the log file, so the cached state is discarded if the log is replaced
+@property (nonatomic) dev_t device;
+@property (nonatomic) ino_t inode;
+/// When the log was last rotated, or created if never rotated. Nil until needed.
+@property (nonatomic, strong) NSDate *started;
+/// If NO, the log or its directory can't be written without authorization
+@property (atomic) BOOL writable;
+- (instancetype)initWithPath:(NSString *)path;
+@end
+
+@interface PGLogRotator ()
+
+/// Rotated logs by expanded path. Access must be synchronized.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, PGRotatedLog *> *logs;
+/// Single background worker for compression, so rotating many logs doesn't swamp the disk
+@property (nonatomic, strong) dispatch_queue_t compressionQueue;
+@property (nonatomic, strong) NSDateFormatter *dateFormatter;
+
+/**
+ * @return the state of the log, created if needed
+ */
+- (PGRotatedLog *)logWithPath:(NSString *)path;
+
+/**
+ * Copies the log to the segment, then truncates the log. Must be called on the log's queue.
+ */
+- (BOOL)copyTruncateLog:(NSString *)path toSegment:(NSString *)segment error:(NSString **)error;
+
+/**
+ * Compresses the segment in the background, then prunes old segments.
+ */
+- (void)compressSegment:(NSString *)segment ofLog:(NSString *)path policy:(PGLogRotationPolicy)policy;
+
+/**
+ * Deletes oldest segments until the log and segments fit within the policy's total size.
+ */
+- (void)pruneLog:(NSString *)path policy:(PGLogRotationPolicy)policy;
+
+/**
+ * @return time the segment was rotated, parsed from its name, or nil if not a segment of the log
+ */
+- (NSDate *)dateOfSegment:(NSString *)segment log:(NSString *)path;
+
+@end
+
+
+
+#pragma mark - PGRotatedLog
+
+@implementation PGRotatedLog
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    self = [super init];
+    if (self) {
+        _queue = dispatch_queue_create([NSString stringWithFormat:@"%@.logrotator.%@", PGPrefsAppID, path.lastPathComponent].UTF8String, DISPATCH_QUEUE_SERIAL);
+        _writable = YES;
+    }
+    return self;
+}
+
+@end
+
+
+
+#pragma mark - PGLogRotator
+
+@implementation PGLogRotator
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _logs = [NSMutableDictionary dictionary];
+        _compressionQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.logrotator.compression", PGPrefsAppID].UTF8String, dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        _dateFormatter = [[NSDateFormatter alloc] init];
+        _dateFormatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        _dateFormatter.dateFormat = PGLogRotatorSegmentDateFormat;
+    }
+    return self;
+}
+
+- (BOOL)rotateLog:(NSString *)path policy:(PGLogRotationPolicy)policy error:(NSString *__autoreleasing *)error
+{
+    path = [path stringByExpandingTildeInPath];
+    if (!NonBlank(path)) return NO;
+    if (policy.maxSize == 0 && policy.maxAge <= 0) return NO;
+    
+    PGRotatedLog *log = [self logWithPath:path];
+    __block BOOL result = NO;
+    __block NSString *resultError = nil;
+    __block NSString *rotatedSegment = nil;
+    dispatch_sync(log.queue, ^{
+        struct stat info;
+        if (stat(path.fileSystemRepresentation, &info) != 0 || info.st_size == 0) return;
+        
+        // Replaced, e.g. deleted and recreated - forget everything known about the old file
+        if (info.st_dev != log.device || info.st_ino != log.inode) {
+            log.device = info.st_dev;
+            log.inode = info.st_ino;
+            log.started = nil;
+            
+            // Never prompt for a password in the background, e.g. for a boot daemon's log
+            log.writable = access(path.fileSystemRepresentation, R_OK | W_OK) == 0 &&
+                access(path.stringByDeletingLastPathComponent.fileSystemRepresentation, W_OK) == 0;
+        }
+        if (!log.writable) return;
+        
+        // Size
+        BOOL rotate = policy.maxSize > 0 && (unsigned long long)info.st_size >= policy.maxSize;
+        
+        // Age - log started when last rotated, or when created if never rotated. Only looks for
+        // segments once per log, after that the time of the last rotation is remembered.
+        NSDate *now = [NSDate date];
+        if (!rotate && policy.maxAge > 0) {
+            if (!log.started) {
+#ifdef __APPLE__
+                NSDate *created = [NSDate dateWithTimeIntervalSince1970:info.st_birthtimespec.tv_sec];
+#else
+                // No creation time in stat - age from when first seen
+                NSDate *created = now;
+#endif
+                log.started = [self dateOfSegment:[self segmentsOfLog:path].firstObject log:path] ?: created;
+            }
+            rotate = [now timeIntervalSinceDate:log.started] >= policy.maxAge;
+        }
+        if (!rotate) return;
+        
+        NSString *segment = [NSString stringWithFormat:@"%@.%@.%@", path.stringByDeletingPathExtension, [self.dateFormatter stringFromDate:now], path.pathExtension.length > 0 ? path.pathExtension : @"log"];
+        NSString *copyError = nil;
+        result = [self copyTruncateLog:path toSegment:segment error:&copyError];
+        resultError = copyError;
+        if (result) {
+            rotatedSegment = segment;
+            log.started = now;
+        }
+    });
+    
+    if (error) *error = resultError;
+    if (rotatedSegment) {
+        DLog(@"Rotated %@ to %@", path, rotatedSegment.lastPathComponent);
+        [self compressSegment:rotatedSegment ofLog:path policy:policy];
+    }
+    return result;
+}
+
+- (BOOL)canRotateLog:(NSString *)path
+{
+    path = [path stringByExpandingTildeInPath];
+    if (!NonBlank(path)) return NO;
+    
+    // Assume so until the log has been checked
+    @synchronized (self.logs) {
+        PGRotatedLog *log = self.logs[path];
+        return !log || log.writable;
+    }
+}
+
+- (NSArray<NSString *> *)segmentsOfLog:(NSString *)path
+{
+    path = [path stringByExpandingTildeInPath];
+    NSString *dir = path.stringByDeletingLastPathComponent;
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:dir error:nil];
+    
+    NSMutableArray *segments = [NSMutableArray array];
+    for (NSString *file in files) {
+        NSString *segment = [dir stringByAppendingPathComponent:file];
+        if ([self dateOfSegment:segment log:path]) [segments addObject:segment];
+    }
+    
+    // Timestamps sort lexically
+    [segments sortUsingComparator:^NSComparisonResult(NSString *segment1, NSString *segment2) {
+        return [segment2.lastPathComponent compare:segment1.lastPathComponent];
+    }];
+    return segments;
+}
+
+
+
+#pragma mark Private
+
+- (PGRotatedLog *)logWithPath:(NSString *)path
+{
+    @synchronized (self.logs) {
+        PGRotatedLog *log = self.logs[path];
+        if (!log) {
+            log = [[PGRotatedLog alloc] initWithPath:path];
+            self.logs[path] = log;
+        }
+        return log;
+    }
+}
+
+- (BOOL)copyTruncateLog:(NSString *)path toSegment:(NSString *)segment error:(NSString *__autoreleasing *)error
+{
+    int src = open(path.fileSystemRepresentation, O_RDWR);
+    if (src < 0) {
+        if (error) *error = [NSString stringWithFormat:@"Cannot open %@: %s", path, strerror(errno)];
+        return NO;
+    }
+    
+    // Exclusive, so an existing segment is never overwritten
+    int dst = open(segment.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (dst < 0) {
+        if (error) *error = [NSString stringWithFormat:@"Cannot create %@: %s", segment, strerror(errno)];
+        close(src);
+        return NO;
+    }
+    
+    // Copy until caught up with the writer
+    BOOL result = YES;
+    char *buffer = malloc(PGLogRotatorCopyChunkSize);
+    ssize_t bytesRead;
+    while (buffer && (bytesRead = read(src, buffer, PGLogRotatorCopyChunkSize)) != 0) {
+        if (bytesRead < 0 || write(dst, buffer, (size_t)bytesRead) != bytesRead) {
+            if (error) *error = [NSString stringWithFormat:@"Cannot copy %@: %s", path, strerror(errno)];
+            result = NO;
+            break;
+        }
+    }
+    if (!buffer) result = NO;
+    free(buffer);
+    
+    // Truncate - the writer appends, so carries on at the new end of file
+    if (result && ftruncate(src, 0) != 0) {
+        if (error) *error = [NSString stringWithFormat:@"Cannot truncate %@: %s", path, strerror(errno)];
+        result = NO;
+    }
+    
+    // Preserve ownership, e.g. log owned by the server's user
+    struct stat info;
+    if (result && fstat(src, &info) == 0) fchown(dst, info.st_uid, info.st_gid);
+    
+    close(dst);
+    close(src);
+    if (!result) unlink(segment.fileSystemRepresentation);
+    return result;
+}
+
+- (void)compressSegment:(NSString *)segment ofLog:(NSString *)path policy:(PGLogRotationPolicy)policy
+{
+    dispatch_async(self.compressionQueue, ^{
+        NSString *error = nil;
+        [PGProcess runExecutable:PGLogRotatorGzip withArgs:@[@"-f", @"-q", segment] error:&error];
+        if (error) DLog(@"Cannot compress %@: %@", segment, error);
+        
+        // Async, so polls waiting to rotate this log are never held up behind the prune
+        dispatch_async([self logWithPath:path].queue, ^{
+            [self pruneLog:path policy:policy];
+        });
+    });
+}
+
+- (void)pruneLog:(NSString *)path policy:(PGLogRotationPolicy)policy
+{
+    if (policy.maxTotalSize == 0) return;
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    unsigned long long total = [[fileManager attributesOfItemAtPath:path error:nil] fileSize];
+    
+    // Keep newest segments that fit
+    for (NSString *segment in [self segmentsOfLog:path]) {
+        total += [[fileManager attributesOfItemAtPath:segment error:nil] fileSize];
+        if (total <= policy.maxTotalSize) continue;
+        
+        DLog(@"Deleting old log %@", segment.lastPathComponent);
+        [fileManager removeItemAtPath:segment error:nil];
+    }
+}
+
+- (NSDate *)dateOfSegment:(NSString *)segment log:(NSString *)path
+{
+    if (!segment) return nil;
+    
+    // E.g. server.20261018-093000.log or server.20261018-093000.log.gz
+    NSString *name = segment.lastPathComponent;
+    if ([name.pathExtension isEqualToString:@"gz"]) name = name.stringByDeletingPathExtension;
+    NSString *prefix = [path.lastPathComponent.stringByDeletingPathExtension stringByAppendingString:@"."];
+    name = name.stringByDeletingPathExtension;
+    if (name.length <= prefix.length || ![name hasPrefix:prefix]) return nil;
+    
+    NSString *stamp = [name substringFromIndex:prefix.length];
+    if (stamp.length != PGLogRotatorSegmentDateLength) return nil;
+    return [self.dateFormatter dateFromString:stamp];
+}
+
+@end
@@ -27,6 +27,45 @@
 #import <Foundation/Foundation.h>
 #import "PGRights.h"
 
+/**
+ * A sample of the resources used by a process and its child processes.
+ */
+typedef struct {
+    /// Time the sample was taken, in seconds since reference date
+    NSTimeInterval time;
+    /// Total user + system CPU time, in seconds
+    NSTimeInterval cpuTime;
+    /// CPU used since the previous sample, as a percentage of one core
+    double cpuPercent;
+    /// Total resident memory, in bytes
+    uint64_t residentBytes;
+    /// Total open file descriptors
+    NSInteger openFiles;
+    /// Number of child processes (for postgres, the backends)
+    NSInteger children;
+} PGProcessUsage;
+
+@class PGProcess;
+
+/**
+ * Replaces the system for process lookups, signals and the clock, e.g. with an in-memory
+ * fake so the server controller can be exercised without real postgres processes.
+ *
+ * Methods are called on any thread, so implementations must be thread-safe.
+ */
+@protocol PGProcessBackend <NSObject>
+/// Monotonic time in seconds
+- (NSTimeInterval)now;
+- (void)sleepForTimeInterval:(NSTimeInterval)interval;
+- (PGProcess *)runningProcessWithPid:(NSInteger)pid;
+- (NSArray *)runningProcessesWithNameLike:(NSString *)pattern;
+- (BOOL)sampleUsage:(PGProcessUsage *)usage forPid:(NSInteger)pid;
+- (BOOL)waitForPid:(NSInteger)pid toExitWithTimeout:(NSTimeInterval)timeout;
+- (BOOL)signal:(int)signal pid:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+/// YES if postmaster.pid in the data directory lists the pid as ready for connections
+- (BOOL)postmasterIsReadyWithDataDirectory:(NSString *)dataDirectory pid:(NSInteger)pid;
+@end
+
 /**
  * Utility class for running executables or shell commands/scripts as subprocesses.
  *
@@ -38,11 +77,28 @@
 @property (nonatomic) NSInteger pid;
 /// Parent process id of running process
 @property (nonatomic) NSInteger ppid;
-/// User of  running process
-@property (nonatomic, strong) PGUser *user;
+/// User id of running process
+@property (nonatomic) NSInteger uid;
+/// User of running process, looked up from the uid when first needed
+@property (nonatomic, strong, readonly) PGUser *user;
 /// Command of running process
 @property (nonatomic, strong) NSString *command;
 
+/// If set, running process lookups, signals and the clock use the backend instead of the system
+@property (class, nonatomic, strong) id<PGProcessBackend> backend;
+
+- (id)initWithPid:(NSInteger)pid ppid:(NSInteger)ppid uid:(NSInteger)uid command:(NSString *)command;
+
+/**
+ * Monotonic time in seconds, from the backend if set.
+ */
++ (NSTimeInterval)now;
+
+/**
+ * Blocks the current thread, using the backend's clock if set.
+ */
++ (void)sleepForTimeInterval:(NSTimeInterval)interval;
+
 /**
  * Gets running process for specified pid.
  */
@@ -53,11 +109,36 @@
  */
 + (NSArray *)runningProcessesWithNameLike:(NSString *)pattern;
 
+/**
+ * Samples the resources used by the process and its direct child processes.
+ *
+ * Uses proc_pidinfo, so is cheap enough to call on every monitoring tick. Note that
+ * processes belonging to other users cannot be sampled unless running as root.
+ *
+ * @return NO if the process is not running or cannot be sampled
+ */
++ (BOOL)sampleUsage:(PGProcessUsage *)usage forPid:(NSInteger)pid;
+
+/**
+ * Blocks until the process exits or the timeout expires.
+ *
+ * Uses a kqueue exit event, so returns as soon as the process exits. Falls back to polling
+ * if the process cannot be watched, e.g. it belongs to another user.
+ *
+ * @return YES if the process is no longer running
+ */
++ (BOOL)waitForPid:(NSInteger)pid toExitWithTimeout:(NSTimeInterval)timeout;
+
 /**
  * Kill a process
  */
 + (BOOL)kill:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
 
+/**
+ * Send a signal to a process, e.g. SIGINT. Only uses authorization for root.
+ */
++ (BOOL)signal:(int)signal pid:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString **)error;
+
 /**
  * The rights required to run an authorized command.
  */
@@ -122,3 +203,65 @@
 + (BOOL)runExecutable:(NSString *)pathToExecutable withArgs:(NSArray *)args auth:(PGAuth *)auth output:(NSString **)output error:(NSString **)error;
 
 @end
+
+/// Block the current thread until condition returns YES or timeout expires, checking often at
+/// first and then backing off. Returns YES if the condition was met. Never call on main thread.
+/// Uses the PGProcess clock, so waits are virtual when a fake backend is set.
+static inline BOOL
+WaitUntil(NSTimeInterval timeout, BOOL(^condition)(void))
+{
+    NSTimeInterval deadline = [PGProcess now] + timeout;
+    NSTimeInterval interval = 0.01;
+    while (!condition()) {
+        NSTimeInterval remaining = deadline - [PGProcess now];
+        if (remaining <= 0) return NO;
+        [PGProcess sleepForTimeInterval:MIN(interval, remaining)];
+        interval = MIN(interval * 2, 0.25);
+    }
+    return YES;
+}
+
+
+
+#pragma mark - PGProcessUsageHistory
+
+/**
+ * Fixed-size ring buffer of usage samples. When full, the oldest sample is overwritten.
+ *
+ * Thread-safe - samples are added on the monitoring thread and read by the GUI.
+ */
+@interface PGProcessUsageHistory : NSObject
+
+/// Maximum number of samples kept
+@property (nonatomic, readonly) NSUInteger capacity;
+/// Number of samples currently kept
+@property (readonly) NSUInteger count;
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ * Adds the sample, calculating its CPU percentage from the previous sample.
+ */
+- (void)addUsage:(PGProcessUsage)usage;
+
+/**
+ * Adds the sample as it is, e.g. one saved previously, keeping its CPU percentage.
+ */
+- (void)restoreUsage:(PGProcessUsage)usage;
+
+/**
+ * Removes all samples, e.g. when the process stops.
+ */
+- (void)removeAllUsage;
+
+/**
+ * @return NO if there are no samples
+ */
+- (BOOL)latestUsage:(PGProcessUsage *)usage;
+
+/**
+ * Calls the block for each sample, from oldest to newest.
+ */
+- (void)enumerateUsageUsingBlock:(void(^)(PGProcessUsage usage))block;
+
+@end
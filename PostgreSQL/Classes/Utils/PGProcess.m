@@ -25,12 +25,26 @@
 //
 
 #import "PGProcess.h"
+#ifdef __APPLE__
+#import <libproc.h>
+#import <sys/proc_info.h>
+#import <mach/mach_time.h>
+#import <sys/event.h>
+#else
+#import <dirent.h>
+#import <signal.h>
+#import <stdio.h>
+#import <unistd.h>
+#endif
 
 #pragma mark - Interfaces
 
 @interface PGProcess ()
 
-- (id)initWithPid:(NSInteger)pid ppid:(NSInteger)ppid user:(PGUser *)user command:(NSString *)command;
+/**
+ * Adds the resources used by a single process to the usage totals.
+ */
++ (BOOL)addUsage:(PGProcessUsage *)usage forPid:(pid_t)pid;
 
 /**
  * @return the applescript file that makes it possible to run an executable with authorization
@@ -68,23 +82,52 @@
 
 @implementation PGProcess
 
+static id<PGProcessBackend> Backend;
+
 #pragma mark Running Processes
 
-- (id)initWithPid:(NSInteger)pid ppid:(NSInteger)ppid user:(PGUser *)user command:(NSString *)command
+- (id)initWithPid:(NSInteger)pid ppid:(NSInteger)ppid uid:(NSInteger)uid command:(NSString *)command
 {
     self = [super init];
     if (self) {
         _pid = pid;
         _ppid = ppid;
-        _user = user;
+        _uid = uid;
         _command = command;
     }
     return self;
 }
 
+- (PGUser *)user
+{
+    return [PGUser userWithUid:_uid];
+}
+
++ (id<PGProcessBackend>)backend
+{
+    @synchronized(self) { return Backend; }
+}
++ (void)setBackend:(id<PGProcessBackend>)backend
+{
+    @synchronized(self) { Backend = backend; }
+}
+
++ (NSTimeInterval)now
+{
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend now];
+    return [NSProcessInfo processInfo].systemUptime;
+}
++ (void)sleepForTimeInterval:(NSTimeInterval)interval
+{
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) [backend sleepForTimeInterval:interval];
+    else [NSThread sleepForTimeInterval:interval];
+}
+
 - (NSString *)description
 {
-    return [NSString stringWithFormat:@"%@ %@ %@ %@", @(_pid), @(_ppid), _user, _command];
+    return [NSString stringWithFormat:@"%@ %@ %@ %@", @(_pid), @(_ppid), @(_uid), _command];
 }
 
 + (PGProcess *)processFromPsCommandOutput:(NSString *)output
@@ -94,7 +137,7 @@
     static NSRegularExpression *regex;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        regex = [NSRegularExpression regularExpressionWithPattern:@"\\A\\s*(\\d+)\\s+(\\d+)\\s+(\\S+)\\s+(.*?)\\s*\\z" options:0 error:nil];
+        regex = [NSRegularExpression regularExpressionWithPattern:@"\\A\\s*(\\d+)\\s+(\\d+)\\s+(\\d+)\\s+(.*?)\\s*\\z" options:0 error:nil];
     });
     
     NSTextCheckingResult *match = [regex firstMatchInString:output options:0 range:NSMakeRange(0,output.length)];
@@ -102,18 +145,24 @@
     
     NSString *pid = [output substringWithRange:[match rangeAtIndex:1]];
     NSString *ppid = [output substringWithRange:[match rangeAtIndex:2]];
-    NSString *user = [output substringWithRange:[match rangeAtIndex:3]];
+    NSString *uid = [output substringWithRange:[match rangeAtIndex:3]];
     NSString *command = [output substringWithRange:[match rangeAtIndex:4]];
-    return [[PGProcess alloc] initWithPid:pid.integerValue ppid:ppid.integerValue user:[PGUser userWithUsername:user] command:command];
+    return [[PGProcess alloc] initWithPid:pid.integerValue ppid:ppid.integerValue uid:uid.integerValue command:command];
 }
 + (PGProcess *)runningProcessWithPid:(NSInteger)pid
 {
-    NSString *command = [NSString stringWithFormat:@"ps -o pid=,ppid=,user=,command= -p %@", @(pid)];
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend runningProcessWithPid:pid];
+    
+    NSString *command = [NSString stringWithFormat:@"ps -o pid=,ppid=,uid=,command= -p %@", @(pid)];
     return [self processFromPsCommandOutput:[self runShellCommand:command error:nil]];
 }
 + (NSArray *)runningProcessesWithNameLike:(NSString *)pattern
 {
-    NSString *command = [NSString stringWithFormat:@"ps -eao pid=,ppid=,user=,command= | grep -v grep | grep -i '%@'", pattern];
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend runningProcessesWithNameLike:pattern];
+    
+    NSString *command = [NSString stringWithFormat:@"ps -eao pid=,ppid=,uid=,command= | grep -v grep | grep -i '%@'", pattern];
     NSArray *lines = [[self runShellCommand:command error:nil] componentsSeparatedByString:@"\n"];
     if (lines.count == 0) return nil;
     
@@ -125,13 +174,179 @@
     return result.count == 0 ? nil : [NSArray arrayWithArray:result];
 }
 
++ (BOOL)sampleUsage:(PGProcessUsage *)usage forPid:(NSInteger)pid
+{
+    if (!usage || pid <= 0) return NO;
+    
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend sampleUsage:usage forPid:pid];
+    
+    *usage = (PGProcessUsage){ .time = [NSDate timeIntervalSinceReferenceDate] };
+    if (![self addUsage:usage forPid:(pid_t)pid]) return NO;
+    
+#ifdef __APPLE__
+    // Child processes - returns size in bytes
+    int size = proc_listpids(PROC_PPID_ONLY, (uint32_t)pid, NULL, 0);
+    if (size <= 0) return YES;
+    
+    // Leave room for processes started in the meantime
+    size += 16 * sizeof(pid_t);
+    pid_t *children = malloc(size);
+    if (!children) return YES;
+    size = proc_listpids(PROC_PPID_ONLY, (uint32_t)pid, children, size);
+    for (int i = 0; i < (int)(size / sizeof(pid_t)); i++) {
+        if (children[i] <= 0) continue;
+        if ([self addUsage:usage forPid:children[i]]) usage->children++;
+    }
+    free(children);
+#else
+    // Child processes - listed per thread, and postgres forks backends from its main thread
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)pid, (int)pid);
+    FILE *file = fopen(path, "r");
+    if (!file) return YES;
+    int child;
+    while (fscanf(file, "%d", &child) == 1) {
+        if (child > 0 && [self addUsage:usage forPid:child]) usage->children++;
+    }
+    fclose(file);
+#endif
+    
+    return YES;
+}
+#ifdef __APPLE__
++ (BOOL)addUsage:(PGProcessUsage *)usage forPid:(pid_t)pid
+{
+    // Task info times are in mach absolute time units
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    
+    // CPU & memory
+    struct proc_taskinfo info;
+    if (proc_pidinfo(pid, PROC_PIDTASKINFO, 0, &info, sizeof(info)) != sizeof(info)) return NO;
+    uint64_t cpuTime = info.pti_total_user + info.pti_total_system;
+    usage->cpuTime += (NSTimeInterval)cpuTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+    usage->residentBytes += info.pti_resident_size;
+    
+    // Open files - calling without a buffer only returns an upper bound
+    int size = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, NULL, 0);
+    if (size > 0) {
+        struct proc_fdinfo *fds = malloc(size);
+        if (fds) {
+            size = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, fds, size);
+            if (size > 0) usage->openFiles += size / PROC_PIDLISTFD_SIZE;
+            free(fds);
+        }
+    }
+    
+    return YES;
+}
+#else
++ (BOOL)addUsage:(PGProcessUsage *)usage forPid:(pid_t)pid
+{
+    // Stat times are in clock ticks, and resident size in pages
+    static long ticks, pageSize;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ticks = sysconf(_SC_CLK_TCK);
+        pageSize = sysconf(_SC_PAGESIZE);
+    });
+    
+    // CPU & memory - fields follow the command, which is in brackets and may contain spaces
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *file = fopen(path, "r");
+    if (!file) return NO;
+    char line[1024];
+    char *fields = fgets(line, sizeof(line), file) ? strrchr(line, ')') : NULL;
+    fclose(file);
+    
+    // Fields 3 to 24 - state ppid pgrp session tty tpgid flags minflt cminflt majflt cmajflt
+    // utime stime cutime cstime priority nice threads itrealvalue starttime vsize rss
+    unsigned long userTicks, systemTicks;
+    long residentPages;
+    if (!fields || sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %*d %*d %*u %*u %ld", &userTicks, &systemTicks, &residentPages) != 3) return NO;
+    if (ticks > 0) usage->cpuTime += (NSTimeInterval)(userTicks + systemTicks) / ticks;
+    if (residentPages > 0 && pageSize > 0) usage->residentBytes += (uint64_t)residentPages * (uint64_t)pageSize;
+    
+    // Open files - only listable for processes of the same user, unless root
+    snprintf(path, sizeof(path), "/proc/%d/fd", (int)pid);
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir))) {
+            if (entry->d_name[0] != '.') usage->openFiles++;
+        }
+        closedir(dir);
+    }
+    
+    return YES;
+}
+#endif
+
++ (BOOL)waitForPid:(NSInteger)pid toExitWithTimeout:(NSTimeInterval)timeout
+{
+    if (pid <= 0) return YES;
+    
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend waitForPid:pid toExitWithTimeout:timeout];
+    
+#ifdef __APPLE__
+    // Watch for exit
+    int kq = kqueue();
+    if (kq >= 0) {
+        struct kevent change, event;
+        EV_SET(&change, (uintptr_t)pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, NULL);
+        struct timespec wait = { (time_t)MAX(0, timeout), (long)((MAX(0, timeout) - floor(MAX(0, timeout))) * NSEC_PER_SEC) };
+        int count = kevent(kq, &change, 1, &event, 1, &wait);
+        int err = errno;
+        close(kq);
+        
+        // Exited - or had already exited before watching began
+        if (count > 0 && !(event.flags & EV_ERROR)) return YES;
+        if (count > 0 && event.data == ESRCH) return YES;
+        if (count < 0 && err == ESRCH) return YES;
+        
+        // Timed out
+        if (count == 0) return NO;
+    }
+#endif
+    
+    // Cannot watch - poll. Note EPERM means still running as another user.
+    return WaitUntil(timeout, ^BOOL{
+        return kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+    });
+}
 + (BOOL)kill:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString *__autoreleasing *)error
 {
     if (pid <= 0) return NO;
     
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend signal:SIGTERM pid:pid forRootUser:root auth:auth error:error];
+    
     NSString *command = [NSString stringWithFormat:@"kill %@", @(pid)];
     return [self runShellCommand:command forRootUser:root auth:auth error:error];
 }
++ (BOOL)signal:(int)signal pid:(NSInteger)pid forRootUser:(BOOL)root auth:(PGAuth *)auth error:(NSString *__autoreleasing *)error
+{
+    if (pid <= 0) return NO;
+    
+    id<PGProcessBackend> backend = self.backend;
+    if (backend) return [backend signal:signal pid:pid forRootUser:root auth:auth error:error];
+    
+    // Own process - no need to run a command
+    if (!root) {
+        if (kill((pid_t)pid, signal) == 0 || errno == ESRCH) return YES;
+        if (error) *error = [NSString stringWithFormat:@"Cannot signal process %@: %s", @(pid), strerror(errno)];
+        return NO;
+    }
+    
+    NSString *command = [NSString stringWithFormat:@"kill -%d %@", signal, @(pid)];
+    return [self runShellCommand:command forRootUser:root auth:auth error:error];
+}
 
 
 
@@ -401,3 +616,100 @@
 }
 
 @end
+
+
+
+#pragma mark - PGProcessUsageHistory
+
+@implementation PGProcessUsageHistory
+{
+    PGProcessUsage *_samples;
+    NSUInteger _first;
+    NSUInteger _count;
+}
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (self) {
+        _capacity = MAX(capacity, 1);
+        _samples = calloc(_capacity, sizeof(PGProcessUsage));
+    }
+    return self;
+}
+- (void)dealloc
+{
+    free(_samples);
+}
+- (NSUInteger)count
+{
+    @synchronized(self) {
+        return _count;
+    }
+}
+- (void)addUsage:(PGProcessUsage)usage
+{
+    @synchronized(self) {
+        // CPU percentage since previous sample
+        usage.cpuPercent = 0;
+        if (_count > 0) {
+            PGProcessUsage previous = _samples[(_first + _count - 1) % _capacity];
+            NSTimeInterval elapsed = usage.time - previous.time;
+            
+            // CPU time goes down if a child process exits
+            if (elapsed > 0 && usage.cpuTime > previous.cpuTime) {
+                usage.cpuPercent = (usage.cpuTime - previous.cpuTime) / elapsed * 100.0;
+            }
+        }
+        
+        [self appendUsage:usage];
+    }
+}
+- (void)restoreUsage:(PGProcessUsage)usage
+{
+    @synchronized(self) {
+        [self appendUsage:usage];
+    }
+}
+/// Call while synchronized
+- (void)appendUsage:(PGProcessUsage)usage
+{
+    // Full - overwrite oldest
+    if (_count == _capacity) {
+        _samples[_first] = usage;
+        _first = (_first + 1) % _capacity;
+    } else {
+        _samples[(_first + _count) % _capacity] = usage;
+        _count++;
+    }
+}
+- (void)removeAllUsage
+{
+    @synchronized(self) {
+        _first = 0;
+        _count = 0;
+    }
+}
+- (BOOL)latestUsage:(PGProcessUsage *)usage
+{
+    @synchronized(self) {
+        if (_count == 0) return NO;
+        if (usage) *usage = _samples[(_first + _count - 1) % _capacity];
+        return YES;
+    }
+}
+- (void)enumerateUsageUsingBlock:(void (^)(PGProcessUsage))block
+{
+    // Copy, so that block is not called while holding lock
+    NSUInteger count;
+    PGProcessUsage *copy;
+    @synchronized(self) {
+        count = _count;
+        if (count == 0) return;
+        copy = malloc(count * sizeof(PGProcessUsage));
+        if (!copy) return;
+        for (NSUInteger i = 0; i < count; i++) copy[i] = _samples[(_first + i) % _capacity];
+    }
+    for (NSUInteger i = 0; i < count; i++) block(copy[i]);
+    free(copy);
+}
+@end
@@ -79,11 +79,18 @@ extern PGAuthReasonKey PGAuthReasonTarget;
 @property (nonatomic, readonly) BOOL requested;
 @property (nonatomic, readonly) OSStatus status;
 @property (nonatomic, weak) id<PGAuthDelegate> delegate;
+/// Set for an auth that shares another's authorization, e.g. one per server in a bulk action
+@property (nonatomic, strong, readonly) PGAuth *parent;
 /// Passed to the delegate when authorization is required, so that the delegate
 /// can inform the user why they need to provide their password.
-@property (nonatomic, strong) NSDictionary<PGAuthReasonKey,NSString *> *reason;
+/// Note: atomic, because a single auth may be shared by actions running concurrently.
+@property (atomic, strong) NSDictionary<PGAuthReasonKey,NSString *> *reason;
 
 - (instancetype)initWithDelegate:(id<PGAuthDelegate>)delegate;
+/// Uses the parent's authorization, but only this auth's requests and failures set requested and status
+/// here. The reason is only passed to the parent if the parent doesn't already have one.
+- (instancetype)initWithParent:(PGAuth *)parent;
+/// Thread-safe. If called concurrently, the delegate is still only asked to authorize once.
 - (AuthorizationRef)authorize:(PGRights *)rights;
 - (AuthorizationRef)authorize:(PGRights *)rights reason:(NSDictionary<PGAuthReasonKey,NSString *> *)reason;
 - (void)invalidate:(OSStatus)status;
@@ -91,10 +98,40 @@ extern PGAuthReasonKey PGAuthReasonTarget;
 
 
 
+#pragma mark - PGAuthSession
+
+/**
+ Keeps an authorization between actions, so the user is only asked for their password
+ again once the rights have expired.
+ 
+ Validity is checked without user interaction, and a successful check is trusted for a
+ short time, so most actions use the authorization without any checks or UI.
+ */
+@interface PGAuthSession : NSObject
+@property (nonatomic, strong, readonly) PGRights *rights;
+/// The current authorization, which may have expired, or NULL
+@property (nonatomic, readonly) AuthorizationRef authorization;
+
+- (instancetype)initWithRights:(PGRights *)rights;
+/// Thread-safe. The authorization if it still holds the rights, otherwise NULL. Never shows UI.
+- (AuthorizationRef)validAuthorization;
+/// Use an authorization obtained elsewhere, e.g. by the UI. Not freed by the session.
+- (void)setAuthorization:(AuthorizationRef)authorization;
+/// Tries to obtain the rights in the background without user interaction, e.g. from credentials
+/// the user entered recently. Completion is called on main thread.
+- (void)preauthorizeWithCompletion:(void(^)(BOOL authorized))completion;
+/// Forget the authorization
+- (void)invalidate;
+@end
+
+
+
 #pragma mark - PGUser
 
 /**
- Username validation and lookup
+ Username validation and lookup.
+ 
+ Users are cached by name and uid, as directory services lookups can be slow.
  */
 @interface PGUser : NSObject
 @property (nonatomic, strong, readonly) NSString *username;
@@ -108,8 +145,12 @@ extern PGAuthReasonKey PGAuthReasonTarget;
 - (instancetype)init NS_UNAVAILABLE;
 /// Case-insensitive check  if username matches this user.
 - (BOOL)hasUsername:(NSString *)username;
-/// Get the user matching the username, or nil if doesn't exist.
+/// Get the user matching the username, or nil if doesn't exist. Lookups are cached, including not found.
 + (PGUser *)userWithUsername:(NSString *)user;
+/// Get the user matching the uid, or nil if doesn't exist. Lookups are cached, including not found.
++ (PGUser *)userWithUid:(NSInteger)uid;
+/// Forget all cached lookups. Called automatically when directory services change.
++ (void)invalidateCache;
 /// Convenience to check if users are equal. If either user is nil, assumed to be current user.
 + (BOOL)isSameUser:(PGUser *)user1 as:(PGUser *)user2;
 @end
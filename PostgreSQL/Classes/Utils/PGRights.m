@@ -25,6 +25,13 @@
 //
 
 #import "PGRights.h"
+#ifdef __APPLE__
+#import <notify.h>
+#import <notify_keys.h>
+#else
+#import <pwd.h>
+#import <sys/stat.h>
+#endif
 
 PGAuthReasonKey PGAuthReasonAction = @"PGAuthReasonAction";
 PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
@@ -57,8 +64,26 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
 }
 @end
 
-@interface PGUser ()
-- (instancetype)initWithUsername:(NSString *)username;
+@interface PGUser () {
+    NSInteger _uid;
+}
+- (instancetype)initWithUsername:(NSString *)username uid:(NSInteger)uid;
+/// Cached users by lowercase username and by uid. NSNull if not found.
++ (NSMutableDictionary<NSString *, id> *)usersByName;
++ (NSMutableDictionary<NSNumber *, id> *)usersByUid;
+/// Registers for directory services change notifications, which invalidate the cache.
+/// Without notifyd, invalidates the cache instead if the passwd file has changed since the last call.
++ (void)initializeCache;
+/// Adds the user to the cache, or a not-found entry for the name/uid if user is nil
++ (void)cacheUser:(PGUser *)user forName:(NSString *)name uid:(NSNumber *)uid;
+/// Directory lookups, uncached. Nil if not found.
++ (PGUser *)lookupUsername:(NSString *)user;
++ (PGUser *)lookupUid:(NSInteger)uid;
+#ifdef __APPLE__
++ (void)queryUser:(NSString *)user resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler;
++ (void)queryUid:(NSInteger)uid resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler;
++ (void)runQuery:(CSIdentityQueryRef)query resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler;
+#endif
 @end
 
 
@@ -163,35 +188,60 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
     }
     return self;
 }
+- (instancetype)initWithParent:(PGAuth *)parent
+{
+    self = [self initWithDelegate:nil];
+    if (self) {
+        _parent = parent;
+    }
+    return self;
+}
 - (AuthorizationRef)authorize:(PGRights *)rights
 {
     return [self authorize:rights reason:nil];
 }
 - (AuthorizationRef)authorize:(PGRights *)rights reason:(NSDictionary<PGAuthReasonKey,NSString *> *)reason
 {
-    if (reason) { _reason = reason; }
-    if (!_requested) {
-        _requested = YES;
-        AuthorizationRef authorization = _authorization = [_delegate authorize:self];
-        _status = authorization ? errAuthorizationSuccess : errAuthorizationCanceled;
+    // Shared - prompt via the parent, but record the outcome for this auth only
+    if (_parent) {
+        if (reason) { self.reason = reason; }
+        AuthorizationRef result = [_parent authorize:rights reason:(_parent.reason ? nil : self.reason)];
+        @synchronized(self) {
+            _requested = YES;
+            _status = result ? errAuthorizationSuccess : (_parent.status ?: errAuthorizationInternal);
+        }
+        return result;
     }
     
-    if (_status == errAuthorizationSuccess) {
-        AuthorizationRef authRef = _authorization;
-        if (!authRef) {
-            _status = errAuthorizationInvalidRef;
-        } else {
-            _status = AuthorizationCopyRights(authRef, rights.authorizationRights, kAuthorizationEmptyEnvironment, kAuthorizationFlagDefaults, NULL);
+    // Other threads sharing this auth wait here while the user is prompted
+    @synchronized(self) {
+        if (reason) { self.reason = reason; }
+        if (!_requested) {
+            _requested = YES;
+            AuthorizationRef authorization = _authorization = [_delegate authorize:self];
+            _status = authorization ? errAuthorizationSuccess : errAuthorizationCanceled;
+        }
+        
+        if (_status == errAuthorizationSuccess) {
+            AuthorizationRef authRef = _authorization;
+            if (!authRef) {
+                _status = errAuthorizationInvalidRef;
+            } else {
+                _status = AuthorizationCopyRights(authRef, rights.authorizationRights, kAuthorizationEmptyEnvironment, kAuthorizationFlagDefaults, NULL);
+            }
         }
-    }
 
-    return _status == errAuthorizationSuccess ? _authorization : NULL;
+        return _status == errAuthorizationSuccess ? _authorization : NULL;
+    }
 }
 - (void)invalidate:(OSStatus)status
 {
-    _requested = YES;
-    if (_status == errAuthorizationSuccess) {
-        _status = status == errAuthorizationSuccess ? errAuthorizationInternal : status;
+    [_parent invalidate:status];
+    @synchronized(self) {
+        _requested = YES;
+        if (_status == errAuthorizationSuccess) {
+            _status = status == errAuthorizationSuccess ? errAuthorizationInternal : status;
+        }
     }
 }
 - (NSString *)description
@@ -207,14 +257,115 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
 
 
 
+#pragma mark - PGAuthSession
+
+@interface PGAuthSession () {
+    AuthorizationRef _authorization;
+    BOOL _ownsAuthorization;
+    NSDate *_validUntil;
+}
+/// Replaces the authorization, freeing the old one if owned
+- (void)setAuthorization:(AuthorizationRef)authorization owned:(BOOL)owned;
+@end
+
+@implementation PGAuthSession
+- (instancetype)initWithRights:(PGRights *)rights
+{
+    self = [super init];
+    if (self) {
+        _rights = rights;
+    }
+    return self;
+}
+- (void)dealloc
+{
+    if (_ownsAuthorization && _authorization) AuthorizationFree(_authorization, kAuthorizationFlagDefaults);
+}
+- (AuthorizationRef)authorization
+{
+    @synchronized(self) {
+        return _authorization;
+    }
+}
+- (AuthorizationRef)validAuthorization
+{
+    @synchronized(self) {
+        if (!_authorization) return NULL;
+        
+        // Recently checked
+        if (_validUntil.timeIntervalSinceNow > 0) return _authorization;
+        
+        // Check without interaction - fails once the credentials have timed out
+        OSStatus status = AuthorizationCopyRights(_authorization, _rights.authorizationRights, kAuthorizationEmptyEnvironment, kAuthorizationFlagDefaults | kAuthorizationFlagExtendRights, NULL);
+        if (status != errAuthorizationSuccess) {
+            DLog(@"Authorization expired: %d", (int) status);
+            _validUntil = nil;
+            return NULL;
+        }
+        
+        _validUntil = [NSDate dateWithTimeIntervalSinceNow:PGAuthSessionRecheckInterval];
+        return _authorization;
+    }
+}
+- (void)setAuthorization:(AuthorizationRef)authorization
+{
+    [self setAuthorization:authorization owned:NO];
+}
+- (void)setAuthorization:(AuthorizationRef)authorization owned:(BOOL)owned
+{
+    @synchronized(self) {
+        if (authorization == _authorization) return;
+        
+        // Freed later, as actions in progress may still be using it
+        if (_ownsAuthorization && _authorization) {
+            AuthorizationRef old = _authorization;
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PGAuthSessionRecheckInterval * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+                AuthorizationFree(old, kAuthorizationFlagDefaults);
+            });
+        }
+        _authorization = authorization;
+        _ownsAuthorization = owned;
+        _validUntil = authorization ? [NSDate dateWithTimeIntervalSinceNow:PGAuthSessionRecheckInterval] : nil;
+    }
+}
+- (void)preauthorizeWithCompletion:(void (^)(BOOL))completion
+{
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        BOOL authorized = [self validAuthorization] != NULL;
+        
+        // Only succeeds if no password is needed
+        if (!authorized) {
+            AuthorizationRef authorization = NULL;
+            OSStatus status = AuthorizationCreate(self.rights.authorizationRights, kAuthorizationEmptyEnvironment, kAuthorizationFlagDefaults | kAuthorizationFlagExtendRights | kAuthorizationFlagPreAuthorize, &authorization);
+            authorized = status == errAuthorizationSuccess && authorization;
+            if (authorized) {
+                [self setAuthorization:authorization owned:YES];
+            } else if (authorization) {
+                AuthorizationFree(authorization, kAuthorizationFlagDefaults);
+            }
+        }
+        
+        DLog(@"Preauthorized: %@", authorized ? @"YES" : @"NO");
+        if (completion) MainThreadAfterDelay(0, ^{ completion(authorized); });
+    });
+}
+- (void)invalidate
+{
+    [self setAuthorization:NULL owned:NO];
+}
+@end
+
+
+
 #pragma mark - PGUser
 
 @implementation PGUser
-- (instancetype)initWithUsername:(NSString *)username
+- (instancetype)initWithUsername:(NSString *)username uid:(NSInteger)uid
 {
     self = [super init];
     if (self) {
         _username = username;
+        _uid = uid;
     }
     return self;
 }
@@ -224,13 +375,11 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
 
 - (NSInteger)uid
 {
-    if (self.isRootUser) { return 0; }
+    if (_uid != NSNotFound) { return _uid; }
 
-    __block NSInteger result = NSNotFound;
-    [PGUser queryUser:_username resultsHandler:^(CSIdentityRef identity) {
-        result = (NSInteger) CSIdentityGetPosixID(identity);
-    }];
-    return result < 0 ? NSNotFound : result;
+    PGUser *user = [PGUser lookupUsername:_username];
+    NSInteger result = user ? user.uid : NSNotFound;
+    return _uid = result < 0 ? NSNotFound : result;
 }
 - (BOOL)hasUsername:(NSString *)username
 {
@@ -257,14 +406,19 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
 
 + (PGUser *)current
 {
-    return [[PGUser alloc] initWithUsername:NSUserName()];
+    static PGUser *result;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        result = [[PGUser alloc] initWithUsername:NSUserName() uid:getuid()];
+    });
+    return result;
 }
 + (PGUser *)root
 {
     static PGUser *result;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        result = [[PGUser alloc] initWithUsername:@"root"];
+        result = [[PGUser alloc] initWithUsername:@"root" uid:0];
     });
     return result;
 }
@@ -275,17 +429,137 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
     if ([user isEqualToStringCaseInsensitive:NSUserName()]) { return self.current; }
     if ([user isEqualToStringCaseInsensitive:@"root"]) { return self.root; }
     
-    __block NSString *username = nil;
+    // Cached
+    NSString *key = user.lowercaseString;
+    @synchronized(self) {
+        id cached = self.usersByName[key];
+        if (cached) { return cached == [NSNull null] ? nil : cached; }
+    }
+    
+    // Lookup
+    PGUser *result = [self lookupUsername:user];
+    if (!result) { DLog(@"User '%@' not found!", user); }
+    [self cacheUser:result forName:key uid:nil];
+    return result;
+}
++ (PGUser *)userWithUid:(NSInteger)uid
+{
+    if (uid == (NSInteger)getuid()) { return self.current; }
+    if (uid == 0) { return self.root; }
+    if (uid < 0 || uid == NSNotFound) { return nil; }
+    
+    // Cached
+    @synchronized(self) {
+        id cached = self.usersByUid[@(uid)];
+        if (cached) { return cached == [NSNull null] ? nil : cached; }
+    }
+    
+    // Lookup
+    PGUser *result = [self lookupUid:uid];
+    if (!result) { DLog(@"User %@ not found!", @(uid)); }
+    [self cacheUser:result forName:nil uid:@(uid)];
+    return result;
+}
++ (void)invalidateCache
+{
+    @synchronized(self) {
+        [self.usersByName removeAllObjects];
+        [self.usersByUid removeAllObjects];
+    }
+}
+
++ (NSMutableDictionary<NSString *,id> *)usersByName
+{
+    [self initializeCache];
+    static NSMutableDictionary *result;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        result = [NSMutableDictionary dictionary];
+    });
+    return result;
+}
++ (NSMutableDictionary<NSNumber *,id> *)usersByUid
+{
+    [self initializeCache];
+    static NSMutableDictionary *result;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        result = [NSMutableDictionary dictionary];
+    });
+    return result;
+}
++ (void)initializeCache
+{
+#ifdef __APPLE__
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Directory services changes, e.g. user added or network directory reconnected
+        static int cacheToken, userToken;
+        dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+        notify_register_dispatch(kNotifyDSCacheInvalidation, &cacheToken, queue, ^(int token) { [PGUser invalidateCache]; });
+        notify_register_dispatch(kNotifyDSCacheInvalidationUser, &userToken, queue, ^(int token) { [PGUser invalidateCache]; });
+    });
+#else
+    // No change notifications - a changed passwd file means users were added, removed or renamed.
+    // Users only known to network directories, e.g. LDAP, stay cached until the process exits.
+    static struct timespec modified;
+    struct stat info;
+    if (stat("/etc/passwd", &info) != 0) return;
+    @synchronized(self) {
+        if (info.st_mtim.tv_sec == modified.tv_sec && info.st_mtim.tv_nsec == modified.tv_nsec) return;
+        modified = info.st_mtim;
+        [self invalidateCache];
+    }
+#endif
+}
++ (void)cacheUser:(PGUser *)user forName:(NSString *)name uid:(NSNumber *)uid
+{
+    @synchronized(self) {
+        // Found - indexed both ways
+        if (user) {
+            self.usersByName[user.username.lowercaseString] = user;
+            if (name) self.usersByName[name] = user;
+            if (user.uid != NSNotFound) self.usersByUid[@(user.uid)] = user;
+            
+        // Not found
+        } else {
+            if (name) self.usersByName[name] = [NSNull null];
+            if (uid) self.usersByUid[uid] = [NSNull null];
+        }
+    }
+}
+
+#ifdef __APPLE__
++ (PGUser *)lookupUsername:(NSString *)user
+{
+    __block PGUser *result = nil;
     [self queryUser:user resultsHandler:^(CSIdentityRef identity) {
-        username = CFBridgingRelease(CSIdentityGetPosixName(identity));
+        result = [[PGUser alloc] initWithUsername:[(__bridge NSString *)CSIdentityGetPosixName(identity) copy] uid:CSIdentityGetPosixID(identity)];
     }];
-    return username ? [[PGUser alloc] initWithUsername:username] : nil;
+    return result;
+}
++ (PGUser *)lookupUid:(NSInteger)uid
+{
+    __block PGUser *result = nil;
+    [self queryUid:uid resultsHandler:^(CSIdentityRef identity) {
+        result = [[PGUser alloc] initWithUsername:[(__bridge NSString *)CSIdentityGetPosixName(identity) copy] uid:uid];
+    }];
+    return result;
 }
-
 + (void)queryUser:(NSString *)user resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler
 {
     CSIdentityQueryRef query = CSIdentityQueryCreateForName(NULL, (__bridge CFStringRef)(user), kCSIdentityQueryStringEquals, kCSIdentityClassUser, CSGetLocalIdentityAuthority());
-
+    [self runQuery:query resultsHandler:resultsHandler];
+    CFRelease(query);
+}
++ (void)queryUid:(NSInteger)uid resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler
+{
+    CSIdentityQueryRef query = CSIdentityQueryCreateForPosixID(NULL, (id_t)uid, kCSIdentityClassUser, CSGetLocalIdentityAuthority());
+    [self runQuery:query resultsHandler:resultsHandler];
+    CFRelease(query);
+}
++ (void)runQuery:(CSIdentityQueryRef)query resultsHandler:(void(^)(CSIdentityRef identity))resultsHandler
+{
     CSIdentityQueryExecute(query, 0, NULL);
     CFArrayRef results = CSIdentityQueryCopyResults(query);
     
@@ -293,11 +567,24 @@ PGAuthReasonKey PGAuthReasonTarget = @"PGAuthReasonTarget";
     if (numResults > 0) {
         CSIdentityRef identity = (CSIdentityRef) CFArrayGetValueAtIndex(results, 0);
         resultsHandler(identity);
-    } else {
-        DLog(@"User '%@' not found!", user);
     }
 
     CFRelease(results);
-    CFRelease(query);
 }
+#else
++ (PGUser *)lookupUsername:(NSString *)user
+{
+    struct passwd entry, *found = NULL;
+    char buffer[4096];
+    if (getpwnam_r(user.UTF8String, &entry, buffer, sizeof(buffer), &found) != 0 || !found) return nil;
+    return [[PGUser alloc] initWithUsername:@(found->pw_name) uid:found->pw_uid];
+}
++ (PGUser *)lookupUid:(NSInteger)uid
+{
+    struct passwd entry, *found = NULL;
+    char buffer[4096];
+    if (getpwuid_r((uid_t)uid, &entry, buffer, sizeof(buffer), &found) != 0 || !found) return nil;
+    return [[PGUser alloc] initWithUsername:@(found->pw_name) uid:uid];
+}
+#endif
 @end
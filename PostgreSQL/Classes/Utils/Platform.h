@@ -0,0 +1,118 @@
+//
+//  Platform.h
+//  PostgresPrefs
+//
+//  Created by Francis McKenzie on 19/10/26.
+//  Copyright (c) 2011-2020 Macca Tech Ltd. (http://macca.tech)
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#ifndef PostgreSQL_Platform_h
+#define PostgreSQL_Platform_h
+
+// The core and command-line tool also build with GNUstep on Linux, where they run against
+// PGFakeSystem instead of launchd. Apple-only calls are guarded with __APPLE__ where they are
+// made. Authorization is used throughout, so it is stubbed here instead: every request is
+// denied, so actions needing admin rights fail with the usual "Authorization required" error.
+
+#ifdef __APPLE__
+
+#import <Security/Security.h>
+
+#else /* !__APPLE__ */
+
+// Apple's Foundation imports both of these
+#import <CoreFoundation/CoreFoundation.h>
+#import <dispatch/dispatch.h>
+#import <stdint.h>
+#import <stddef.h>
+#import <stdio.h>
+
+#ifndef NS_EXTENSIBLE_STRING_ENUM
+#define NS_EXTENSIBLE_STRING_ENUM
+#endif
+#ifndef NS_UNAVAILABLE
+#define NS_UNAVAILABLE __attribute__((unavailable))
+#endif
+
+typedef int32_t OSStatus;
+
+typedef struct AuthorizationOpaqueRef *AuthorizationRef;
+typedef uint32_t AuthorizationFlags;
+
+typedef struct {
+    const char *name;
+    size_t valueLength;
+    void *value;
+    uint32_t flags;
+} AuthorizationItem;
+
+typedef struct {
+    uint32_t count;
+    AuthorizationItem *items;
+} AuthorizationItemSet;
+
+typedef AuthorizationItemSet AuthorizationRights;
+typedef AuthorizationItemSet AuthorizationEnvironment;
+
+enum {
+    errAuthorizationSuccess = 0,
+    errAuthorizationInvalidRef = -60002,
+    errAuthorizationDenied = -60005,
+    errAuthorizationCanceled = -60006,
+    errAuthorizationInternal = -60008,
+};
+
+enum {
+    kAuthorizationFlagDefaults = 0,
+    kAuthorizationFlagInteractionAllowed = (1 << 0),
+    kAuthorizationFlagExtendRights = (1 << 1),
+    kAuthorizationFlagPartialRights = (1 << 2),
+    kAuthorizationFlagDestroyRights = (1 << 3),
+    kAuthorizationFlagPreAuthorize = (1 << 4),
+};
+
+#define kAuthorizationEmptyEnvironment NULL
+#define kAuthorizationRightExecute "system.privilege.admin"
+
+static inline OSStatus AuthorizationCreate(const AuthorizationRights *rights, const AuthorizationEnvironment *environment, AuthorizationFlags flags, AuthorizationRef *authorization)
+{
+    if (authorization) *authorization = NULL;
+    return errAuthorizationDenied;
+}
+
+static inline OSStatus AuthorizationFree(AuthorizationRef authorization, AuthorizationFlags flags)
+{
+    return authorization ? errAuthorizationSuccess : errAuthorizationInvalidRef;
+}
+
+static inline OSStatus AuthorizationCopyRights(AuthorizationRef authorization, const AuthorizationRights *rights, const AuthorizationEnvironment *environment, AuthorizationFlags flags, AuthorizationRights **authorizedRights)
+{
+    return authorization ? errAuthorizationDenied : errAuthorizationInvalidRef;
+}
+
+static inline OSStatus AuthorizationExecuteWithPrivileges(AuthorizationRef authorization, const char *pathToTool, AuthorizationFlags options, char *const *arguments, FILE **communicationsPipe)
+{
+    return authorization ? errAuthorizationDenied : errAuthorizationInvalidRef;
+}
+
+#endif /* __APPLE__ */
+
+#endif /* PostgreSQL_Platform_h */